@@ -14,18 +14,18 @@ and a zero flag (ZF). The simulator includes bounds checking and simple
 error messages for invalid accesses and opcodes.
 
 */
-// OpCodes
+// OpCodes (misma numeración que Export_week4/cpu_core.h)
 enum {
     NOP   = 0x00,
     LOAD  = 0x01, // ACC = MEM[addr]
     ADD   = 0x02, // ACC = ACC + MEM[addr]
     STORE = 0x03, // MEM[addr] = ACC
-    LOADI = 0x04, // ACC = imm8
-    SUB   = 0x05, // ACC = ACC - MEM[addr]
-    JMP   = 0x06, // PC  = addr
-    JZ    = 0x07, // if ZF==1 -> PC = addr
-    JNZ   = 0x08, // if ZF==0 -> PC = addr
-    PRINT = 0x09, // printf("%u\n", ACC)
+    JMP   = 0x04, // PC  = addr
+    JZ    = 0x05, // if ZF==1 -> PC = addr
+    PRINT = 0x06, // printf("%u\n", ACC)
+    SUB   = 0x08, // ACC = ACC - MEM[addr]
+    JNZ   = 0x09, // if ZF==0 -> PC = addr
+    LOADI = 0x0A, // ACC = imm8
     HALT  = 0xFF
 };
 
@@ -172,4 +172,4 @@ int main(void) {
         printf("Resultado guardado en [0x12]=%u\n", (unsigned)memory[0x12]);
     }
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -30,6 +30,8 @@ enum {
     JMP   = 0x04,
     JZ    = 0x05,
     PRINT = 0x06, // debug: print RESULT and COUNTER
+    LOADI = 0x0A, // ACC = imm8 (numeración de Export_week4/cpu_core.h)
+    SUBI  = 0x0C, // ACC = ACC - imm8
     HALT  = 0xFF
 };
 
@@ -45,10 +47,7 @@ enum {
     RESULT  = 0xC1, // running result
     COUNTER = 0xC2, // outer counter
     TEMP    = 0xC3, // temp for multiply
-    PART    = 0xC4, // partial sum
-    NEG1    = 0xF0, // −1 (0xFF)
-    ONE     = 0xF1, // 1
-    ZERO    = 0xF2  // 0
+    PART    = 0xC4  // partial sum
 };
 
 static int fetch_u8(uint8_t *out) {
@@ -89,6 +88,16 @@ static void fetch_decode_execute(void) {
                 ACC = (uint8_t)(ACC + memory[a]); // 8-bit wrap
             } break;
 
+            case LOADI: {
+                uint8_t imm; if (fetch_u8(&imm) != 0) return;
+                ACC = imm;
+            } break;
+
+            case SUBI: {
+                uint8_t imm; if (fetch_u8(&imm) != 0) return;
+                ACC = (uint8_t)(ACC - imm); // 8-bit wrap
+            } break;
+
             case STORE: {
                 uint8_t a; if (fetch_addr(&a) != 0) return;
                 memory[a] = ACC;
@@ -125,18 +134,13 @@ static void fetch_decode_execute(void) {
 static void load_factorial_program(uint8_t n_value) {
     memset(memory, 0, sizeof memory);
 
-    // constants
-    memory[NEG1] = 0xFF;
-    memory[ONE]  = 0x01;
-    memory[ZERO] = 0x00;
-
     // input N
     memory[N] = n_value;
 
     uint8_t p = 0x00;
 
     // RESULT = 1
-    memory[p++] = LOAD;  memory[p++] = ONE;
+    memory[p++] = LOADI; memory[p++] = 1;
     memory[p++] = STORE; memory[p++] = RESULT;
 
     // COUNTER = N
@@ -151,7 +155,7 @@ static void load_factorial_program(uint8_t n_value) {
     memory[p++] = JZ;    uint8_t END_patch = p++; // placeholder
 
     // PART = 0
-    memory[p++] = LOAD;  memory[p++] = ZERO;
+    memory[p++] = LOADI; memory[p++] = 0;
     memory[p++] = STORE; memory[p++] = PART;
 
     // TEMP = RESULT
@@ -170,9 +174,9 @@ static void load_factorial_program(uint8_t n_value) {
     memory[p++] = ADD;   memory[p++] = COUNTER;
     memory[p++] = STORE; memory[p++] = PART;
 
-    // TEMP = TEMP - 1   (ADD −1)
+    // TEMP = TEMP - 1
     memory[p++] = LOAD;  memory[p++] = TEMP;
-    memory[p++] = ADD;   memory[p++] = NEG1;
+    memory[p++] = SUBI;  memory[p++] = 1;
     memory[p++] = STORE; memory[p++] = TEMP;
 
     // goto INNER
@@ -190,7 +194,7 @@ static void load_factorial_program(uint8_t n_value) {
 
     // COUNTER = COUNTER - 1
     memory[p++] = LOAD;  memory[p++] = COUNTER;
-    memory[p++] = ADD;   memory[p++] = NEG1;
+    memory[p++] = SUBI;  memory[p++] = 1;
     memory[p++] = STORE; memory[p++] = COUNTER;
 
     // goto LOOP
@@ -4,17 +4,35 @@
 #
 gcc assembler.c -o assembler.x
 
-gcc assembler_v2.c -o assembler_v2.x
+gcc assembler_v2.c asm_lib.c -o assembler_v2.x
+# (asm_lib.c/.h: el mismo ensamblador como biblioteca, asm_assemble() en memoria)
 
 gcc cpu_loader.c -o cpu_loader.x
 
 gcc cpu_loader_v2.c -o cpu_loader_v2.x
 
+gcc linker.c -o linker.x
+
+gcc disasm.c -o disasm.x
+# (isa.h: la tabla de instrucciones que comparten todos -- ensamblador,
+#  cargador, desensamblador y las CPUs de Export_week4)
+
 
 # CREAR EL MEM CON ASSEMBLER
 ./assembler_v2.x factorialB.asm factorialBout
+# (-O: optimiza antes de emitir -- cargas redundantes, saltos a saltos,
+#  stores muertos -- e informa cuantas instrucciones quito)
+# ./assembler_v2.x -O factorialB.asm factorialBout
 
 
 # EJECUTAR CON CARGADOR 
 ./cpu_loader_v2.x factorialBout.mem
 
+# Objeto binario (.obj, ver mem_obj.h): segmentos + entry + simbolos, cargado con mmap
+./cpu_loader_v2.x factorialBout.obj
+
+# LINKER: modulos con .global/.extern -> una sola imagen (ver Export_week4)
+# ./linker.x -o programa.obj modulo1.obj modulo2.obj
+
+# DESENSAMBLADOR: .mem/.bin/.obj -> fuente que el ensamblador vuelve a dar
+./disasm.x factorialBout.obj
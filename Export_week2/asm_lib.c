@@ -0,0 +1,1146 @@
+// asm_lib.c  -- two-pass assembler for tiny ISA (instructions in isa.h; "LOAD #5" = LOADI 5,
+// "LOAD [P]" = LOADP P, "LOAD T,X" = LOADX T)
+// Library form of assembler_v2 (see asm_lib.h): all the state of one
+// assembly lives in an asm_ctx, and errors longjmp back to asm_assemble().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <setjmp.h>
+
+#include "asm_lib.h"
+#include "isa.h"
+
+#define MEM_SIZE     256
+
+
+// Symbol table: symtab[] keeps definition order (sorted only for the
+// dump at the end); symhash[] is an open-addressing index into it
+// (linear probing, slot = index+1, 0 = empty), kept at most half full.
+// Names are interned in the arena (one copy per definition).
+typedef struct {
+    const char *name;
+    int value;
+    int flags;         // MEM_OBJ_SYM_*
+    uint32_t hash;
+    int ir;            // etiquetas: índice en ir[] de la línea que marcan; -1 si no
+} Symbol;
+
+// Arena: bump allocation in blocks, freed all at once at the end.
+// Holds the IR (tokens, clean source text) and the interned symbol names.
+typedef struct ArenaBlock { struct ArenaBlock *next; size_t used, size; char data[]; } ArenaBlock;
+
+typedef struct {
+    int addr;          // dirección donde comienza la emisión de esta línea
+    int nbytes;        // bytes emitidos (0,1,2)
+    uint8_t bytes[2];  // hasta 2 bytes (nuestra ISA actual)
+    const char *source; // línea fuente (limpia, en la arena)
+} Listing;
+
+// =====================================
+// IR: each source line is parsed once
+// =====================================
+// PASS 1 builds one IrLine per line that emits or directs something
+// (label-only and comment lines leave none) while it defines symbols;
+// PASS 2 only walks ir[] and resolves operands.
+typedef enum { IR_INSN, IR_ORG, IR_BYTE, IR_EQU, IR_ENTRY, IR_GLOBAL, IR_EXTERN } IrKind;
+
+typedef struct {
+    const char *sym;   // symbol name, or NULL if the operand is a number
+    int value;         // parse_number() value when sym == NULL
+} Operand;
+
+typedef struct {
+    IrKind kind;
+    int line;            // línea fuente (1..n) para los mensajes de error
+    int op;              // IR_INSN: opcode
+    int value;           // IR_ORG, IR_BYTE fijada: dirección
+    int pinned;          // IR_BYTE: se emite en value (-O no mueve los datos)
+    int removed;         // -O: la instrucción no se emite
+    const char *name;    // mnemónico / directiva tal como se escribió
+    int nargs;
+    Operand *args;       // IR_INSN/IR_ENTRY: operandos; IR_BYTE: valores;
+                         // IR_GLOBAL: nombres
+    const char *src;     // texto sin etiqueta ni comentario (listing)
+} IrLine;
+
+// Everything one asm_assemble() call owns
+typedef struct {
+    jmp_buf fail;
+    asm_result *out;
+
+    Symbol *symtab;
+    int symcount, symcap;
+    int *symhash;
+    uint32_t hashcap;    // power of 2
+
+    ArenaBlock *arena;
+
+    IrLine *ir;
+    int nir, ir_cap;
+
+    Listing *listing;
+    int list_count, list_cap;
+
+    // Módulo relocatable (.global/.extern): reloc_at[a] = símbolo (etiqueta
+    // o extern) cuyo valor final va en el byte a; NULL si es absoluto.
+    const char *reloc_at[MEM_SIZE];
+
+    char *text;          // listing text
+    size_t text_len, text_cap;
+
+    void *scratch;       // arrays of the optimizer
+
+    isa_hash_t mnemonics; // mnemónico -> opcode (hash perfecto de ISA_TABLE)
+} asm_ctx;
+
+static void die(asm_ctx *A, const char *fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(A->out->error, sizeof A->out->error, fmt, ap);
+    va_end(ap);
+    longjmp(A->fail, 1);
+}
+
+static void *arena_alloc(asm_ctx *A, size_t n){
+    n = (n + 7) & ~(size_t)7;
+    if(!A->arena || A->arena->size - A->arena->used < n){
+        size_t size = n > 65536 ? n : 65536;
+        ArenaBlock *b = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+        if(!b) die(A, "out of memory");
+        b->next = A->arena; b->used = 0; b->size = size;
+        A->arena = b;
+    }
+    void *p = A->arena->data + A->arena->used;
+    A->arena->used += n;
+    return p;
+}
+
+static const char *arena_strndup(asm_ctx *A, const char *s, size_t n){
+    char *dst = (char*)arena_alloc(A, n + 1);
+    memcpy(dst, s, n);
+    dst[n] = 0;
+    return dst;
+}
+
+static void arena_free(ArenaBlock *arena){
+    while(arena){ ArenaBlock *next = arena->next; free(arena); arena = next; }
+}
+
+static uint32_t hash_name(const char *s){
+    uint32_t h = 2166136261u;   // FNV-1a
+    while(*s){ h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+
+// slot where name is, or the empty slot where it would go
+static uint32_t hash_slot(const asm_ctx *A, const char *name, uint32_t h){
+    uint32_t i = h & (A->hashcap-1);
+    while(A->symhash[i]){
+        const Symbol *sym = &A->symtab[A->symhash[i]-1];
+        if(sym->hash == h && strcmp(sym->name, name)==0) break;
+        i = (i+1) & (A->hashcap-1);
+    }
+    return i;
+}
+
+static void rehash_symbols(asm_ctx *A){
+    memset(A->symhash, 0, A->hashcap * sizeof(int));
+    for(int k=0;k<A->symcount;k++)
+        A->symhash[hash_slot(A, A->symtab[k].name, A->symtab[k].hash)] = k+1;
+}
+
+static void grow_symbols(asm_ctx *A){
+    int cap = A->symcap ? A->symcap*2 : 256;
+    Symbol *bigger = (Symbol*)realloc(A->symtab, (size_t)cap * sizeof(Symbol));
+    if(!bigger) die(A, "out of memory");
+    A->symtab = bigger;
+    A->symcap = cap;
+    free(A->symhash);
+    A->hashcap = (uint32_t)cap * 2;
+    A->symhash = (int*)calloc(A->hashcap, sizeof(int));
+    if(!A->symhash) die(A, "out of memory");
+    rehash_symbols(A);
+}
+
+static int find_symbol(const asm_ctx *A, const char *name){
+    if(A->symcount==0) return -1;
+    return A->symhash[hash_slot(A, name, hash_name(name))] - 1;
+}
+// name must live in the arena
+static void add_symbol(asm_ctx *A, const char *name, int value, int flags){
+    if(find_symbol(A, name) != -1){
+        A->out->error_bare = 1;     // assembler_v2 always printed it bare
+        die(A, "Symbol redefinition: %s", name);
+    }
+    if(A->symcount >= A->symcap) grow_symbols(A);
+    uint32_t h = hash_name(name);
+    Symbol *s = &A->symtab[A->symcount];
+    s->name = name;
+    s->value = value & 0xFF;
+    s->flags = flags;
+    s->hash = h;
+    s->ir = -1;
+    A->symhash[hash_slot(A, name, h)] = A->symcount+1;
+    A->symcount++;
+}
+
+static int parse_number(const char *tok, int *ok){
+    *ok = 1;
+    if(tok[0]=='0' && tok[1]=='x'){ return (int)strtol(tok+2, NULL, 16); }
+    if(tok[0]=='0' && tok[1]=='b'){ return (int)strtol(tok+2, NULL, 2); }
+    if(isdigit((unsigned char)tok[0]) || (tok[0]=='-' && isdigit((unsigned char)tok[1]))){
+        return (int)strtol(tok, NULL, 10);
+    }
+    *ok = 0; return 0;
+}
+
+static void add_listing(asm_ctx *A, int addr, int nbytes, uint8_t b0, uint8_t b1, const char *clean_src){
+    if(A->list_count >= A->list_cap){
+        int cap = A->list_cap ? A->list_cap*2 : 256;
+        Listing *bigger = (Listing*)realloc(A->listing, (size_t)cap * sizeof(Listing));
+        if(!bigger) die(A, "out of memory");
+        A->listing = bigger;
+        A->list_cap = cap;
+    }
+    Listing *l = &A->listing[A->list_count++];
+    l->addr = addr;
+    l->nbytes = nbytes;
+    l->bytes[0] = b0;
+    l->bytes[1] = b1;
+    l->source = clean_src;
+}
+
+// printf() onto the end of the listing text
+static void text_printf(asm_ctx *A, const char *fmt, ...){
+    for(;;){
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(A->text + A->text_len, A->text_cap - A->text_len, fmt, ap);
+        va_end(ap);
+        if(n < 0) die(A, "listing format error");
+        if(A->text_len + (size_t)n < A->text_cap){ A->text_len += (size_t)n; return; }
+
+        size_t cap = A->text_cap ? A->text_cap*2 : 4096;
+        while(cap <= A->text_len + (size_t)n) cap *= 2;
+        char *bigger = (char*)realloc(A->text, cap);
+        if(!bigger) die(A, "out of memory");
+        A->text = bigger;
+        A->text_cap = cap;
+    }
+}
+
+
+static int cmp_symbols(const void *a, const void *b){
+    const Symbol *sa = (const Symbol*)a;
+    const Symbol *sb = (const Symbol*)b;
+    return strcmp(sa->name, sb->name);
+}
+
+static Operand make_operand(const char *tok){
+    Operand o; int ok;
+    o.value = parse_number(tok, &ok);
+    o.sym = ok ? NULL : tok;
+    return o;
+}
+
+static int resolve(const asm_ctx *A, const Operand *o, int *ok){
+    *ok = 1;
+    if(!o->sym) return o->value & 0xFF;
+    int idx = find_symbol(A, o->sym);
+    if(idx>=0) return A->symtab[idx].value & 0xFF;
+    *ok = 0; return 0;
+}
+
+// Symbol an operand must be relocated against (labels and externs of a
+// relocatable module), or NULL
+static const char *reloc_symbol(const asm_ctx *A, const Operand *o){
+    if(!A->out->relocatable || !o->sym) return NULL;
+    int idx = find_symbol(A, o->sym);
+    return idx>=0 && !(A->symtab[idx].flags & MEM_OBJ_SYM_ABS) ? A->symtab[idx].name : NULL;
+}
+
+// Opcode that takes op's operand as an immediate ("LOAD #5" is LOADI 5),
+// -1 if op has no immediate form
+static int immediate_form(int op){
+    switch(op){
+    case OP_LOAD:  case OP_LOADI: return OP_LOADI;
+    case OP_ADD:   case OP_ADDI:  return OP_ADDI;
+    case OP_SUB:   case OP_SUBI:  return OP_SUBI;
+    default:       return -1;
+    }
+}
+
+// Opcode that reads op's operand through a pointer ("LOAD [P]" is
+// LOADP P), -1 if there is none
+static int pointer_form(int op){
+    switch(op){
+    case OP_LOAD:  case OP_LOADP:  return OP_LOADP;
+    case OP_ADD:   case OP_ADDP:   return OP_ADDP;
+    case OP_STORE: case OP_STOREP: return OP_STOREP;
+    default:       return -1;
+    }
+}
+
+// Opcode that adds X to op's operand ("LOAD T,X" is LOADX T), -1 if
+// there is none
+static int indexed_form(int op){
+    switch(op){
+    case OP_LOAD:  case OP_LOADX:  return OP_LOADX;
+    case OP_ADD:   case OP_ADDX:   return OP_ADDX;
+    case OP_STORE: case OP_STOREX: return OP_STOREX;
+    default:       return -1;
+    }
+}
+
+// Splits [p, end) at whitespace (and, with commas != 0, at ',' too) into
+// arena strings; returns how many tokens there are.
+static int split_tokens(asm_ctx *A, const char *p, const char *end, int commas, const char **toks){
+    int n = 0;
+    while(p < end){
+        while(p < end && (isspace((unsigned char)*p) || (commas && *p==','))) p++;
+        if(p == end) break;
+        const char *start = p;
+        while(p < end && !isspace((unsigned char)*p) && !(commas && *p==',')) p++;
+        if(toks) toks[n] = arena_strndup(A, start, (size_t)(p - start));
+        n++;
+    }
+    return n;
+}
+
+// Label (if any) and body span of source line [raw, e). Returns 0 if the line
+// is empty or a comment. *label is NULL if there is none; *body == *end
+// if the line holds only a label.
+static int split_line(asm_ctx *A, const char *raw, const char *e,
+                      const char **label, const char **body, const char **end){
+    while(e > raw && isspace((unsigned char)e[-1])) e--;
+    const char *s = raw;
+    while(s < e && isspace((unsigned char)*s)) s++;
+    if(s == e || *s==';') return 0;
+
+    *label = NULL;
+    const char *colon = memchr(s, ':', (size_t)(e - s));
+    if(colon){
+        if(colon == s) die(A, "empty label");
+        *label = arena_strndup(A, s, (size_t)(colon - s));
+        s = colon + 1;
+        while(s < e && isspace((unsigned char)*s)) s++;
+    }
+
+    // sin comentario y sin espacios finales
+    const char *c = s;
+    while(c < e && *c != ';') c++;
+    e = c;
+    while(e > s && isspace((unsigned char)e[-1])) e--;
+    *body = s; *end = e;
+    return 1;
+}
+
+// Parses the body of one line into *ir and advances *pc (PASS 1).
+// Returns 0 if the body is empty.
+static int parse_body(asm_ctx *A, const char *s, const char *e, int lineno, int *pc, IrLine *ir){
+    if(s == e) return 0;
+    memset(ir, 0, sizeof *ir);
+    ir->line = lineno;
+    ir->src = arena_strndup(A, s, (size_t)(e - s));
+
+    const char *toks_end = s;
+    while(toks_end < e && !isspace((unsigned char)*toks_end)) toks_end++;
+    ir->name = arena_strndup(A, s, (size_t)(toks_end - s));
+
+    // .byte/.global/.extern separan también por comas; el resto sólo por espacios
+    int is_byte = strcmp(ir->name, ".byte")==0;
+    int commas = is_byte || strcmp(ir->name, ".global")==0 || strcmp(ir->name, ".extern")==0;
+    // instrucción "base,X": el ",X" marca el modo indexado y no es un token
+    int indexed = 0;
+    const char *comma = ir->name[0]!='.' ? memchr(toks_end, ',', (size_t)(e - toks_end)) : NULL;
+    if(comma){
+        const char *r = comma + 1;
+        while(r < e && isspace((unsigned char)*r)) r++;
+        if(e - r != 1 || toupper((unsigned char)*r) != 'X')
+            die(A, "Expected base,X (line %d)", lineno);
+        e = comma;
+        indexed = 1;
+    }
+    int nt = split_tokens(A, toks_end, e, commas, NULL);
+    const char **toks = (const char**)arena_alloc(A, sizeof(char*) * (size_t)(nt ? nt : 1));
+    split_tokens(A, toks_end, e, commas, toks);
+
+    if(ir->name[0]=='.'){
+        if(strcmp(ir->name, ".org")==0){
+            if(nt<1) die(A, ".org expects a value");
+            int ok; int v = parse_number(toks[0], &ok);
+            if(!ok || v<0 || v>=MEM_SIZE) die(A, ".org value invalid/out of range");
+            ir->kind = IR_ORG;
+            ir->value = v;
+            *pc = v;
+            return 1;
+        } else if(is_byte){
+            ir->kind = IR_BYTE;
+            *pc += nt;
+        } else if(strcmp(ir->name, ".equ")==0){
+            if(nt<2) die(A, ".equ NAME VALUE");
+            int ok; int v = parse_number(toks[1], &ok);
+            if(!ok) die(A, ".equ VALUE must be numeric for pass1");
+            add_symbol(A, toks[0], v, MEM_OBJ_SYM_ABS);
+            ir->kind = IR_EQU;
+            return 1;
+        } else if(strcmp(ir->name, ".extern")==0){
+            for(int k=0;k<nt;k++) add_symbol(A, toks[k], 0, MEM_OBJ_SYM_EXTERN);
+            A->out->relocatable = 1;
+            ir->kind = IR_EXTERN;
+            return 1;
+        } else if(strcmp(ir->name, ".global")==0){
+            // se marcan tras pass1 (el símbolo puede definirse después)
+            A->out->relocatable = 1;
+            ir->kind = IR_GLOBAL;
+        } else if(strcmp(ir->name, ".entry")==0){
+            if(nt<1) die(A, ".entry expects a label or value");
+            // se resuelve en pass2 (puede ser una etiqueta posterior)
+            ir->kind = IR_ENTRY;
+        } else {
+            die(A, "Unknown directive: %s", ir->name);
+        }
+    } else {
+        ir->op = isa_hash_lookup(&A->mnemonics, ir->name);
+        if(ir->op < 0) die(A, "Unknown mnemonic (pass1): %s (line %d)", ir->name, lineno);
+        ir->kind = IR_INSN;
+        *pc += isa_insn_len((uint8_t)ir->op);
+        if(nt>0 && toks[0][0]=='#'){
+            // #imm: el valor va en el byte del operando, sin acceso a memoria
+            if(immediate_form(ir->op) < 0)
+                die(A, "%s takes no immediate operand (line %d)", ir->name, lineno);
+            ir->op = immediate_form(ir->op);
+            if(!*++toks[0]) die(A, "Missing immediate value (line %d)", lineno);
+        } else if(nt>0 && toks[0][0]=='['){
+            // [P]: el byte P guarda la dirección del dato
+            size_t n = strlen(toks[0]);
+            if(pointer_form(ir->op) < 0)
+                die(A, "%s takes no [pointer] operand (line %d)", ir->name, lineno);
+            if(n < 3 || toks[0][n-1] != ']') die(A, "Expected [address] (line %d)", lineno);
+            ir->op = pointer_form(ir->op);
+            toks[0] = arena_strndup(A, toks[0]+1, n-2);
+        }
+        if(indexed){
+            if(indexed_form(ir->op) < 0)
+                die(A, "%s takes no indexed operand (line %d)", ir->name, lineno);
+            ir->op = indexed_form(ir->op);
+        }
+    }
+
+    ir->nargs = nt;
+    ir->args = (Operand*)arena_alloc(A, sizeof(Operand) * (size_t)(nt ? nt : 1));
+    for(int k=0;k<nt;k++) ir->args[k] = make_operand(toks[k]);
+    return 1;
+}
+
+// =====================================
+// PASS 1: parse every line once into ir[], symbols and PC
+// =====================================
+static void pass1(asm_ctx *A, const char *src, size_t len){
+    int pc = 0;
+    const char *line = src, *src_end = src + len;
+    for(int lineno=1; line < src_end; lineno++){
+        const char *nl = memchr(line, '\n', (size_t)(src_end - line));
+        const char *line_end = nl ? nl : src_end;
+        const char *label, *body, *end;
+        if(split_line(A, line, line_end, &label, &body, &end)){
+            if(label){
+                add_symbol(A, label, pc, 0);
+                A->symtab[A->symcount-1].ir = A->nir;
+            }
+            if(A->nir >= A->ir_cap){
+                int cap = A->ir_cap ? A->ir_cap*2 : 256;
+                IrLine *bigger = (IrLine*)realloc(A->ir, (size_t)cap * sizeof(IrLine));
+                if(!bigger) die(A, "out of memory");
+                A->ir = bigger;
+                A->ir_cap = cap;
+            }
+            if(parse_body(A, body, end, lineno, &pc, &A->ir[A->nir])) A->nir++;
+        }
+        line = line_end + 1;
+    }
+
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_GLOBAL) continue;
+        for(int k=0;k<ln->nargs;k++){
+            const char *name = ln->args[k].sym ? ln->args[k].sym : "(number)";
+            int idx = ln->args[k].sym ? find_symbol(A, name) : -1;
+            if(idx<0 || (A->symtab[idx].flags & MEM_OBJ_SYM_EXTERN))
+                die(A, "Undefined .global: %s (line %d)", name, ln->line);
+            A->symtab[idx].flags |= MEM_OBJ_SYM_GLOBAL;
+        }
+    }
+}
+
+// =====================================
+// OPTIMIZER (-O)
+// =====================================
+// Runs on ir[] between the two passes, over the control-flow graph of
+// the instructions: edges are fall-through and jump targets; the
+// roots (entry point, .global labels, labels named by a .byte or an
+// immediate) start with nothing known, and every other label is a join
+// point where the facts of all incoming edges meet. Repeated until
+// nothing changes:
+//   - jump threading: a jump to a JMP (or a JZ to a JZ, a JC to a JC...)
+//     goes straight to the final target; jumps to the next instruction
+//     and instructions no root reaches are dropped;
+//   - redundant loads: LOAD X when ACC holds [X] on every path (after a
+//     STORE X or LOAD X that nothing in between invalidated; a STOREP or
+//     STOREX only writes ACC, so it invalidates nothing);
+//   - dead stores: STORE X to a private slot that no path reads before it
+//     is stored again (a read through a pointer or X, LOADP or LOADX...,
+//     may read any slot). Leaving the module, by HALT or by a jump to an
+//     .extern, is not the end: the linker may call any root again with
+//     memory kept, so what a root reads is live there. Only in modules that
+//     declare their interface with .global; a slot is private if its
+//     .byte has a label, none of them .global, and nothing names it by
+//     number: as an operand, a .byte value, an immediate (#SLOT is its
+//     address) or the value of an .equ.
+// Dropped instructions emit nothing and the code labels after them move
+// down; .byte data is pinned to its address, so whoever reads the image
+// by address still finds the data where it was. A program that reads or
+// writes its own code, jumps to a numeric address or can run into data
+// is left as is (opt.skipped says why).
+
+typedef struct { uint64_t w[MEM_SIZE/64]; } AddrSet;
+
+static void set_add(AddrSet *s, int a){ s->w[a>>6] |= (uint64_t)1 << (a&63); }
+static void set_del(AddrSet *s, int a){ s->w[a>>6] &= ~((uint64_t)1 << (a&63)); }
+static int  set_has(const AddrSet *s, int a){ return (int)(s->w[a>>6] >> (a&63)) & 1; }
+
+static int is_transparent(IrKind k){
+    return k==IR_EQU || k==IR_GLOBAL || k==IR_EXTERN || k==IR_ENTRY;
+}
+
+// Addresses pass2 will give each line (pc_at[nir] = end) and, if owner is
+// not NULL, the line that emits each byte (-1 = none)
+static void layout(const asm_ctx *A, int *pc_at, int *owner){
+    int pc = 0;
+    if(owner) for(int a=0;a<MEM_SIZE;a++) owner[a] = -1;
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->pinned) pc = ln->value;
+        pc_at[i] = pc;
+        int n = 0;
+        if(ln->removed) n = 0;
+        else if(ln->kind == IR_ORG) pc = ln->value;
+        else if(ln->kind == IR_BYTE) n = ln->nargs;
+        else if(ln->kind == IR_INSN) n = isa_insn_len((uint8_t)ln->op);
+        for(int k=0;k<n;k++) if(owner && pc+k>=0 && pc+k<MEM_SIZE) owner[pc+k] = i;
+        pc += n;
+    }
+    pc_at[A->nir] = pc;
+}
+
+typedef struct {
+    int *fall;      // siguiente instrucción si no salta; -1 = datos / fin
+    int *tgt;       // saltos: instrucción destino; -1 = extern
+    int *addr;      // LOAD/ADD/STORE...: dirección (layout original); -1 = extern
+                    // o inmediato
+    int *roots;
+    int nroots;
+    size_t nlines;  // nir
+    uint8_t *mark;  // alcanzable / estado conocido
+    AddrSet *in;    // por instrucción: hechos a la entrada / vivos a la entrada
+    AddrSet exit;   // vivos al salir del módulo: los vivos a la entrada de
+                    // alguna raíz
+    uint8_t priv[MEM_SIZE];
+} OptCfg;
+
+// First instruction at or after line i (lines that emit nothing in
+// between), -1 if data or the end comes first
+static int next_insn(const asm_ctx *A, int i){
+    while(i < A->nir && is_transparent(A->ir[i].kind)) i++;
+    return i < A->nir && A->ir[i].kind == IR_INSN ? i : -1;
+}
+
+// Instruction that really runs when control reaches i (dropped ones fall through)
+static int skip_removed(const asm_ctx *A, const OptCfg *g, int i){
+    while(i >= 0 && A->ir[i].removed) i = g->fall[i];
+    return i;
+}
+
+// Successors of instruction i; -1 = leaves the module. Returns how many.
+static int successors(const asm_ctx *A, const OptCfg *g, int i, int succ[2]){
+    int op = A->ir[i].op;
+    if(op == OP_HALT) return 0;
+    if(isa_kind((uint8_t)op) != ISA_JUMP){
+        succ[0] = skip_removed(A, g, g->fall[i]);
+        return 1;
+    }
+    succ[0] = g->tgt[i] < 0 ? -1 : skip_removed(A, g, g->tgt[i]);
+    if(op == OP_JMP) return 1;
+    succ[1] = skip_removed(A, g, g->fall[i]);   // JZ, JNZ, JC
+    return 2;
+}
+
+// The instruction reads [addr]: every data operand but STORE's, and the
+// pointer of LOADP/ADDP/STOREP
+static int reads_addr(int op){
+    int kind = isa_kind((uint8_t)op);
+    return (kind == ISA_ADDR && op != OP_STORE) || kind == ISA_PTR;
+}
+
+// The instruction reads a byte whose address is only known at run time
+// (through a pointer or X), so it may read any slot
+static int reads_any(int op){
+    return op == OP_LOADP || op == OP_ADDP || op == OP_LOADX || op == OP_ADDX;
+}
+
+// The instruction changes ACC
+static int writes_acc(int op){
+    if(op == OP_STORE || op == OP_STOREP || op == OP_STOREX) return 0;
+    int kind = isa_kind((uint8_t)op);
+    return kind == ISA_ADDR || kind == ISA_IMM || kind == ISA_PTR || kind == ISA_IDX || op == OP_TXA;
+}
+
+// Checks that the program can be optimized and fills the CFG. Returns 0,
+// or -1 with opt.skipped set.
+static int build_cfg(asm_ctx *A, OptCfg *g, const int *pc_at, const int *owner){
+    asm_opt_stats *st = &A->out->opt;
+    int has_global = 0, has_entry = 0;
+
+    for(int i=0;i<A->nir;i++){
+        IrLine *ln = &A->ir[i];
+        g->fall[i] = g->tgt[i] = g->addr[i] = -1;
+        if(ln->kind == IR_GLOBAL) has_global = 1;
+        if(ln->kind == IR_ENTRY){
+            int idx = ln->args[0].sym ? find_symbol(A, ln->args[0].sym) : -1;
+            if(idx<0 || A->symtab[idx].ir<0 || next_insn(A, A->symtab[idx].ir)<0){
+                snprintf(st->skipped, sizeof st->skipped, "line %d: .entry is not a code label", ln->line);
+                return -1;
+            }
+            g->roots[g->nroots++] = next_insn(A, A->symtab[idx].ir);
+            has_entry = 1;
+        }
+        if(ln->kind != IR_INSN) continue;
+        int len = isa_insn_len((uint8_t)ln->op);
+        if(len == 2 && ln->nargs < 1) return -1;            // pass2 reports it
+
+        g->fall[i] = next_insn(A, i+1);
+        if(g->fall[i] < 0 && ln->op != OP_HALT && ln->op != OP_JMP){
+            snprintf(st->skipped, sizeof st->skipped, "line %d: execution runs into data", ln->line);
+            return -1;
+        }
+        if(len == 1) continue;
+
+        const Operand *o = &ln->args[0];
+        int idx = o->sym ? find_symbol(A, o->sym) : -1;
+        if(o->sym && idx<0) return -1;                      // pass2 reports it
+        int ext = idx>=0 && (A->symtab[idx].flags & MEM_OBJ_SYM_EXTERN);
+        if(isa_kind((uint8_t)ln->op) == ISA_JUMP){
+            if(ext) continue;
+            if(idx<0 || A->symtab[idx].ir<0){
+                snprintf(st->skipped, sizeof st->skipped, "line %d: jump to a numeric address", ln->line);
+                return -1;
+            }
+            g->tgt[i] = next_insn(A, A->symtab[idx].ir);
+            if(g->tgt[i] < 0){
+                snprintf(st->skipped, sizeof st->skipped, "line %d: jump into data", ln->line);
+                return -1;
+            }
+        } else if(!ext && isa_kind((uint8_t)ln->op) != ISA_IMM){
+            int a = (idx>=0 ? A->symtab[idx].value : o->value) & 0xFF;
+            if(owner[a]>=0 && A->ir[owner[a]].kind == IR_INSN){
+                snprintf(st->skipped, sizeof st->skipped, "line %d: %s reads or writes code", ln->line, ln->name);
+                return -1;
+            }
+            g->addr[i] = a;
+        }
+    }
+
+    // raíces: entrada, etiquetas .global y etiquetas nombradas en .byte o
+    // en un inmediato
+    if(!has_entry && owner[0]>=0 && A->ir[owner[0]].kind == IR_INSN && pc_at[owner[0]]==0)
+        g->roots[g->nroots++] = owner[0];
+    for(int k=0;k<A->symcount;k++){
+        const Symbol *s = &A->symtab[k];
+        if(s->ir >= 0 && (s->flags & MEM_OBJ_SYM_GLOBAL) && next_insn(A, s->ir) >= 0)
+            g->roots[g->nroots++] = next_insn(A, s->ir);
+    }
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_BYTE && !(ln->kind == IR_INSN && isa_kind((uint8_t)ln->op) == ISA_IMM)) continue;
+        for(int k=0;k<ln->nargs;k++){
+            int idx = ln->args[k].sym ? find_symbol(A, ln->args[k].sym) : -1;
+            if(idx>=0 && A->symtab[idx].ir>=0 && next_insn(A, A->symtab[idx].ir)>=0)
+                g->roots[g->nroots++] = next_insn(A, A->symtab[idx].ir);
+        }
+    }
+    if(g->nroots == 0){
+        snprintf(st->skipped, sizeof st->skipped, "no entry point (.entry or code at 0x00)");
+        return -1;
+    }
+
+    // private slots
+    memset(g->priv, 0, sizeof g->priv);
+    if(!has_global) return 0;
+    for(int pass=0;pass<2;pass++){
+        for(int k=0;k<A->symcount;k++){
+            const Symbol *s = &A->symtab[k];
+            if(s->ir<0 || A->ir[s->ir].kind != IR_BYTE) continue;
+            if(pass == !!(s->flags & MEM_OBJ_SYM_GLOBAL)){
+                for(int b=0;b<A->ir[s->ir].nargs;b++)
+                    if(pc_at[s->ir]+b < MEM_SIZE) g->priv[pc_at[s->ir]+b] = (uint8_t)!pass;
+            }
+        }
+    }
+    // un .equ nombra su valor por número (un .global OUT = 0xC1 exporta el slot)
+    for(int k=0;k<A->symcount;k++)
+        if(A->symtab[k].flags & MEM_OBJ_SYM_ABS) g->priv[A->symtab[k].value & 0xFF] = 0;
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->kind == IR_INSN && ln->nargs>0 && !ln->args[0].sym && g->addr[i]>=0)
+            g->priv[g->addr[i]] = 0;
+        if(ln->kind != IR_BYTE && !(ln->kind == IR_INSN && isa_kind((uint8_t)ln->op) == ISA_IMM)) continue;
+        for(int k=0;k<ln->nargs;k++){
+            int idx = ln->args[k].sym ? find_symbol(A, ln->args[k].sym) : -1;
+            if(idx>=0 && !(A->symtab[idx].flags & MEM_OBJ_SYM_EXTERN))
+                g->priv[A->symtab[idx].value & 0xFF] = 0;
+        }
+    }
+    return 0;
+}
+
+static int thread_jumps(asm_ctx *A, OptCfg *g){
+    int changed = 0;
+    for(int i=0;i<A->nir;i++){
+        IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_INSN || ln->removed ||
+           isa_kind((uint8_t)ln->op) != ISA_JUMP) continue;
+        if(g->tgt[i] < 0) continue;
+
+        int t = skip_removed(A, g, g->tgt[i]);
+        for(int hops=0; t>=0 && t!=i && hops<A->nir; hops++){
+            const IrLine *tl = &A->ir[t];
+            if(!(tl->op == OP_JMP || (ln->op != OP_JMP && tl->op == ln->op))) break;
+            Operand *arg = (Operand*)arena_alloc(A, sizeof(Operand));
+            *arg = tl->args[0];
+            ln->args = arg;
+            g->tgt[i] = g->tgt[t];
+            A->out->opt.jumps++;
+            changed = 1;
+            if(g->tgt[i] < 0) break;
+            t = skip_removed(A, g, g->tgt[i]);
+        }
+
+        if(g->tgt[i] >= 0 && g->fall[i] >= 0 &&
+           skip_removed(A, g, g->tgt[i]) == skip_removed(A, g, g->fall[i])){
+            ln->removed = 1;
+            A->out->opt.jumps++;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static int drop_unreachable(asm_ctx *A, OptCfg *g){
+    int *stack = g->roots + g->nroots;    // room for one entry per line
+    int top = 0, changed = 0;
+    memset(g->mark, 0, g->nlines);
+    for(int r=0;r<g->nroots;r++){
+        int i = skip_removed(A, g, g->roots[r]);
+        if(i>=0 && !g->mark[i]){ g->mark[i] = 1; stack[top++] = i; }
+    }
+    while(top > 0){
+        int succ[2], i = stack[--top];
+        int n = successors(A, g, i, succ);
+        for(int k=0;k<n;k++){
+            if(succ[k]>=0 && !g->mark[succ[k]]){ g->mark[succ[k]] = 1; stack[top++] = succ[k]; }
+        }
+    }
+    for(int i=0;i<A->nir;i++){
+        IrLine *ln = &A->ir[i];
+        if(ln->kind == IR_INSN && !ln->removed && !g->mark[i]){
+            ln->removed = 1;
+            A->out->opt.unreachable++;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// Forward: in[i] = addresses X with [X] == ACC on every path into i
+static int drop_redundant_loads(asm_ctx *A, OptCfg *g){
+    memset(g->mark, 0, g->nlines);
+    for(int r=0;r<g->nroots;r++){
+        int i = skip_removed(A, g, g->roots[r]);
+        if(i<0) continue;
+        memset(&g->in[i], 0, sizeof(AddrSet));
+        g->mark[i] = 1;
+    }
+
+    int changed;
+    do {
+        changed = 0;
+        for(int i=0;i<A->nir;i++){
+            const IrLine *ln = &A->ir[i];
+            if(ln->kind != IR_INSN || ln->removed || !g->mark[i]) continue;
+            AddrSet out = g->in[i];
+            int a = g->addr[i];
+            if(ln->op == OP_LOAD){
+                if(a<0 || !set_has(&out, a)){
+                    memset(&out, 0, sizeof out);
+                    if(a>=0) set_add(&out, a);
+                }
+            } else if(writes_acc(ln->op)){
+                memset(&out, 0, sizeof out);
+            } else if(ln->op == OP_STORE && a>=0){
+                set_add(&out, a);
+            }
+
+            int succ[2], n = successors(A, g, i, succ);
+            for(int k=0;k<n;k++){
+                int s = succ[k];
+                if(s<0) continue;
+                if(!g->mark[s]){
+                    g->in[s] = out;
+                    g->mark[s] = 1;
+                    changed = 1;
+                    continue;
+                }
+                for(int w=0;w<MEM_SIZE/64;w++){
+                    uint64_t m = g->in[s].w[w] & out.w[w];
+                    if(m != g->in[s].w[w]){ g->in[s].w[w] = m; changed = 1; }
+                }
+            }
+        }
+    } while(changed);
+
+    for(int i=0;i<A->nir;i++){
+        IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_INSN || ln->removed || ln->op != OP_LOAD || !g->mark[i]) continue;
+        if(g->addr[i]>=0 && set_has(&g->in[i], g->addr[i])){
+            ln->removed = 1;
+            A->out->opt.loads++;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// Backward: in[i] = private slots some path from i reads before storing.
+// HALT and jumps to an .extern leave the module with g->exit live.
+static AddrSet live_out(const asm_ctx *A, const OptCfg *g, int i){
+    AddrSet out;
+    int succ[2], n = successors(A, g, i, succ);
+    if(n == 0) return g->exit;
+    memset(&out, 0, sizeof out);
+    for(int k=0;k<n;k++){
+        const AddrSet *s = succ[k] < 0 ? &g->exit : &g->in[succ[k]];
+        for(int w=0;w<MEM_SIZE/64;w++) out.w[w] |= s->w[w];
+    }
+    return out;
+}
+
+static int drop_dead_stores(asm_ctx *A, OptCfg *g){
+    memset(g->in, 0, sizeof(AddrSet) * g->nlines);
+    memset(&g->exit, 0, sizeof g->exit);
+    int changed;
+    do {
+        changed = 0;
+        for(int r=0;r<g->nroots;r++){
+            int i = skip_removed(A, g, g->roots[r]);
+            if(i<0) continue;
+            for(int w=0;w<MEM_SIZE/64;w++){
+                uint64_t m = g->exit.w[w] | g->in[i].w[w];
+                if(m != g->exit.w[w]){ g->exit.w[w] = m; changed = 1; }
+            }
+        }
+        for(int i=A->nir-1;i>=0;i--){
+            const IrLine *ln = &A->ir[i];
+            if(ln->kind != IR_INSN || ln->removed) continue;
+            AddrSet in = live_out(A, g, i);
+            int a = g->addr[i];
+            if(reads_any(ln->op)) memset(&in, 0xFF, sizeof in);
+            if(a>=0 && g->priv[a]){
+                if(reads_addr(ln->op))
+                    set_add(&in, a);
+                else if(ln->op == OP_STORE) set_del(&in, a);
+            }
+            if(memcmp(&in, &g->in[i], sizeof in) != 0){ g->in[i] = in; changed = 1; }
+        }
+    } while(changed);
+
+    for(int i=0;i<A->nir;i++){
+        IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_INSN || ln->removed || ln->op != OP_STORE) continue;
+        int a = g->addr[i];
+        if(a<0 || !g->priv[a]) continue;
+        AddrSet out = live_out(A, g, i);
+        if(!set_has(&out, a)){
+            ln->removed = 1;
+            A->out->opt.stores++;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static void count_code(const asm_ctx *A, int *insns, int *bytes){
+    *insns = *bytes = 0;
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->kind != IR_INSN || ln->removed) continue;
+        (*insns)++;
+        *bytes += isa_insn_len((uint8_t)ln->op);
+    }
+}
+
+static void optimize(asm_ctx *A){
+    asm_opt_stats *st = &A->out->opt;
+    int n = A->nir;
+    count_code(A, &st->insns_before, &st->bytes_before);
+    st->insns_after = st->insns_before;
+    st->bytes_after = st->bytes_before;
+    if(st->insns_before == 0) return;
+
+    // un solo bloque para todo; se libera al terminar asm_assemble()
+    size_t ints = (size_t)n*3 + (size_t)(n+1) + (size_t)n*3 + MEM_SIZE;
+    A->scratch = malloc(ints*sizeof(int) + (size_t)n*sizeof(AddrSet) + (size_t)n);
+    if(!A->scratch) die(A, "out of memory");
+    OptCfg g;
+    g.in = (AddrSet*)A->scratch;
+    int *p = (int*)(g.in + n);
+    g.fall = p;  p += n;
+    g.tgt  = p;  p += n;
+    g.addr = p;  p += n;
+    int *pc_at = p; p += n+1;
+    g.roots = p; p += (size_t)n*3;        // roots (<= 2 per line) + DFS stack
+    int *owner = p; p += MEM_SIZE;
+    g.mark = (uint8_t*)p;
+    g.nroots = 0;
+    g.nlines = (size_t)n;
+
+    layout(A, pc_at, owner);
+    if(build_cfg(A, &g, pc_at, owner) != 0) return;
+
+    // los datos no se mueven
+    for(int i=0;i<n;i++){
+        if(A->ir[i].kind != IR_BYTE) continue;
+        A->ir[i].pinned = 1;
+        A->ir[i].value = pc_at[i];
+    }
+
+    for(int round=0; round<16; round++){
+        int changed = thread_jumps(A, &g);
+        changed |= drop_unreachable(A, &g);
+        changed |= drop_redundant_loads(A, &g);
+        changed |= drop_dead_stores(A, &g);
+        if(!changed) break;
+    }
+
+    // las etiquetas toman su dirección en el código ya reducido
+    layout(A, pc_at, NULL);
+    for(int k=0;k<A->symcount;k++){
+        if(A->symtab[k].ir >= 0) A->symtab[k].value = pc_at[A->symtab[k].ir] & 0xFF;
+    }
+    count_code(A, &st->insns_after, &st->bytes_after);
+}
+
+// =====================================
+// PASS 2: emit bytes and build listing
+// =====================================
+static void pass2(asm_ctx *A){
+    asm_result *r = A->out;
+    uint8_t *out_mem = r->mem, *used = r->used, *code = r->code;
+    const char **reloc_at = A->reloc_at;
+    int pc = 0;
+
+    for(int i=0;i<A->nir;i++){
+        const IrLine *ln = &A->ir[i];
+        if(ln->removed) continue;
+        if(ln->pinned) pc = ln->value;
+        int start_addr = pc;
+        int nbytes_emitted = 0;
+        uint8_t b0=0, b1=0;
+
+        switch(ln->kind){
+        case IR_ORG:
+            pc = ln->value;
+            // .org no emite bytes -> listing con 0 bytes
+            break;
+        case IR_BYTE:
+            for(int k=0;k<ln->nargs;k++){
+                int v = ln->args[k].value;
+                if(ln->args[k].sym){
+                    int idx = find_symbol(A, ln->args[k].sym);
+                    if(idx<0)
+                        die(A, "Unknown symbol in .byte: %s (line %d)", ln->args[k].sym, ln->line);
+                    v = A->symtab[idx].value;
+                }
+                if(pc<0 || pc>=MEM_SIZE) die(A, ".byte out of mem range");
+                out_mem[pc] = (uint8_t)(v & 0xFF);
+                used[pc] = 1; code[pc] = 0;
+                reloc_at[pc] = reloc_symbol(A, &ln->args[k]);
+                if(nbytes_emitted < 2){
+                    if(nbytes_emitted==0) b0 = out_mem[pc];
+                    else b1 = out_mem[pc];
+                }
+                nbytes_emitted++;
+                pc++;
+            }
+            break;
+        case IR_EQU:
+        case IR_GLOBAL:
+        case IR_EXTERN:
+            // no emiten bytes; ya registrados en pass1
+            break;
+        case IR_ENTRY: {
+            int ok; r->entry = (uint8_t)resolve(A, &ln->args[0], &ok);
+            if(!ok) die(A, "Undefined .entry: %s (line %d)", ln->args[0].sym, ln->line);
+            break;
+        }
+        case IR_INSN:
+            if(isa_insn_len((uint8_t)ln->op) == 1){
+                // mismo texto que el assembler_v2 original: "HALT out of range"
+                if(pc<0 || pc>=MEM_SIZE) die(A, "%s out of range", isa_find((uint8_t)ln->op)->name);
+                out_mem[pc] = (uint8_t)ln->op; used[pc]=1; code[pc]=1; reloc_at[pc]=NULL;
+                b0 = out_mem[pc];
+                nbytes_emitted=1; pc++;
+                break;
+            }
+            if(ln->nargs<1) die(A, "Missing operand for %s (line %d)", ln->name, ln->line);
+            if(pc<0 || pc+1>=MEM_SIZE) die(A, "instruction out of memory range");
+            out_mem[pc] = (uint8_t)ln->op; used[pc]=1; code[pc]=1; reloc_at[pc]=NULL;
+            b0 = out_mem[pc]; pc++;
+            int ok; int val = resolve(A, &ln->args[0], &ok);
+            if(!ok) die(A, "Undefined operand: %s (line %d)", ln->args[0].sym, ln->line);
+            out_mem[pc] = (uint8_t)(val & 0xFF); used[pc]=1; code[pc]=1;
+            reloc_at[pc] = reloc_symbol(A, &ln->args[0]);
+            b1 = out_mem[pc]; pc++;
+            nbytes_emitted = 2;
+            break;
+        }
+
+        if(r->want_listing) add_listing(A, start_addr, nbytes_emitted, b0, b1, ln->src);
+    }
+}
+
+// Listing table + symbol table (symtab ya ordenada)
+static void build_listing(asm_ctx *A){
+    text_printf(A, "ADDR  BYTES      SOURCE\n");
+    text_printf(A, "====  =====     ========= \n");
+    for(int i=0;i<A->list_count;i++){
+        const Listing *l = &A->listing[i];
+        if(l->nbytes==0){
+            text_printf(A, "      %-10s %s\n", "", l->source);
+        } else if(l->nbytes==1){
+            text_printf(A, "%04X  %02X         %s\n", l->addr, l->bytes[0], l->source);
+        } else {
+            text_printf(A, "%04X  %02X %02X     %s\n", l->addr, l->bytes[0], l->bytes[1], l->source);
+        }
+    }
+
+    text_printf(A, "\nSYMBOLS (%d):\n", A->symcount);
+    for(int i=0;i<A->symcount;i++){
+        text_printf(A, "  %-20s = 0x%02X (%3d)\n",
+                    A->symtab[i].name, A->symtab[i].value, A->symtab[i].value);
+    }
+}
+
+static void assemble(asm_ctx *A, const char *src, size_t len){
+    asm_result *r = A->out;
+
+    if(isa_hash_init(&A->mnemonics) != 0) die(A, "isa.h: mnemonics do not fit ISA_HASH_SLOTS");
+    pass1(A, src, len);
+    if(r->optimize) optimize(A);
+    pass2(A);
+
+    for(int i=0;i<MEM_SIZE;i++) if(r->used[i]) r->last = i;
+
+    // sorted by name: the .obj loader looks symbols up by bisection
+    if(A->symcount > 0){
+        qsort(A->symtab, (size_t)A->symcount, sizeof(Symbol), cmp_symbols);
+        rehash_symbols(A);
+    }
+    if(r->want_listing) build_listing(A);
+
+    r->syms = (mem_obj_symdef_t*)arena_alloc(A, sizeof(mem_obj_symdef_t) * (size_t)(A->symcount ? A->symcount : 1));
+    for(int i=0;i<A->symcount;i++){
+        r->syms[i].name  = A->symtab[i].name;
+        r->syms[i].value = (uint8_t)A->symtab[i].value;
+        r->syms[i].flags = (uint8_t)A->symtab[i].flags;
+    }
+    r->nsyms = A->symcount;
+    for(int a=0;a<MEM_SIZE;a++){
+        if(!r->used[a] || !A->reloc_at[a]) continue;
+        r->relocs[r->nrelocs].addr = (uint8_t)a;
+        r->relocs[r->nrelocs].sym  = (uint16_t)find_symbol(A, A->reloc_at[a]);
+        r->nrelocs++;
+    }
+}
+
+int asm_assemble(const char *src, size_t len, asm_result *out){
+    int want_listing = out->want_listing, opt = out->optimize;
+    memset(out, 0, sizeof *out);
+    out->want_listing = want_listing;
+    out->optimize = opt;
+
+    asm_ctx *A = (asm_ctx*)calloc(1, sizeof(asm_ctx));
+    if(!A){
+        snprintf(out->error, sizeof out->error, "out of memory");
+        return -1;
+    }
+    A->out = out;
+
+    int rc = 0;
+    if(setjmp(A->fail) == 0){
+        assemble(A, src, len);
+        // the arena holds the symbol names: it goes with the result
+        out->priv = A->arena;
+        A->arena = NULL;
+        out->listing = A->text;
+        out->listing_len = A->text_len;
+        A->text = NULL;
+    } else {
+        char error[sizeof out->error];
+        int bare = out->error_bare;
+        memcpy(error, out->error, sizeof error);
+        memset(out, 0, sizeof *out);
+        out->want_listing = want_listing;
+        out->optimize = opt;
+        memcpy(out->error, error, sizeof error);
+        out->error_bare = bare;
+        rc = -1;
+    }
+
+    arena_free(A->arena);
+    free(A->text);
+    free(A->symtab);
+    free(A->symhash);
+    free(A->ir);
+    free(A->listing);
+    free(A->scratch);
+    free(A);
+    return rc;
+}
+
+void asm_result_free(asm_result *out){
+    arena_free((ArenaBlock*)out->priv);
+    free(out->listing);
+    out->priv = NULL;
+    out->listing = NULL;
+    out->listing_len = 0;
+    out->syms = NULL;
+    out->nsyms = 0;
+}
+
+void asm_result_obj(const asm_result *r, mem_obj_out_t *obj){
+    memset(obj, 0, sizeof *obj);
+    obj->mem     = r->mem;
+    obj->used    = r->used;
+    obj->code    = r->code;
+    obj->entry   = r->entry;
+    obj->flags   = r->relocatable ? MEM_OBJ_RELOCATABLE : 0;
+    obj->syms    = r->syms;
+    obj->nsyms   = r->nsyms;
+    obj->relocs  = r->relocs;
+    obj->nrelocs = r->nrelocs;
+}
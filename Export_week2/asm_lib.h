@@ -0,0 +1,79 @@
+// asm_lib.h -- the two-pass assembler of assembler_v2 as a library
+//
+// asm_assemble() takes the source text in memory and returns everything
+// assembler_v2 writes to disk (memory image, symbol table, relocations,
+// listing) in an asm_result, so a generator can build a program and hand
+// it to the CPU without any file or process in between:
+//
+//     asm_result r = { .want_listing = 0 };
+//     if (asm_assemble(text, strlen(text), &r) != 0) {
+//         fprintf(stderr, "ERROR: %s\n", r.error);
+//     } else {
+//         cpu_load(&cpu, r.mem);
+//         ...
+//     }
+//     asm_result_free(&r);
+//
+// There is no global state (every call has its own symbol table, IR and
+// arena, so threads can assemble in parallel) and errors never exit():
+// the call returns -1 with the message in r.error and nothing allocated.
+
+#ifndef ASM_LIB_H
+#define ASM_LIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem_obj.h"
+
+// What -O did (see OPTIMIZER in asm_lib.c)
+typedef struct {
+    int insns_before, insns_after;  // static instruction counts
+    int bytes_before, bytes_after;  // bytes of code
+    int loads;                      // redundant LOADs removed
+    int stores;                     // dead STOREs removed
+    int jumps;                      // jumps threaded or removed
+    int unreachable;                // unreachable instructions removed
+    char skipped[96];               // why the program was left as is ("" if not)
+} asm_opt_stats;
+
+typedef struct {
+    // in
+    int want_listing;               // also build the listing text
+    int optimize;                   // -O
+
+    // out (all of it rewritten by every call)
+    uint8_t mem[MEM_OBJ_MEM_SIZE];  // image, 0 where nothing was emitted
+    uint8_t used[MEM_OBJ_MEM_SIZE]; // 1 = emitted
+    uint8_t code[MEM_OBJ_MEM_SIZE]; // 1 = byte of an instruction
+    int     last;                   // last used address (0 if none)
+    uint8_t entry;                  // .entry, 0 by default
+    int     relocatable;            // the source uses .global/.extern
+    asm_opt_stats opt;              // with optimize
+
+    mem_obj_symdef_t *syms;         // sorted by name
+    int nsyms;
+    mem_obj_relocdef_t relocs[MEM_OBJ_MEM_SIZE];
+    int nrelocs;
+
+    char  *listing;                 // "ADDR  BYTES  SOURCE" table + symbols,
+    size_t listing_len;             // NULL unless want_listing
+
+    char error[160];                // message when asm_assemble() fails
+    int  error_bare;                // 1: assembler_v2 prints it without
+                                    // "ERROR: " (symbol redefinitions)
+
+    void *priv;                     // storage of the symbol names
+} asm_result;
+
+// Assembles src[0..len) (no NUL needed). Returns 0, or -1 with out->error
+// set. Call asm_result_free() after either.
+int asm_assemble(const char *src, size_t len, asm_result *out);
+
+void asm_result_free(asm_result *out);
+
+// Fills an .obj description of r (the .obj of assembler_v2) for
+// mem_obj_write()
+void asm_result_obj(const asm_result *r, mem_obj_out_t *obj);
+
+#endif
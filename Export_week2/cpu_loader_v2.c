@@ -1,5 +1,6 @@
 // cpu_loader_v2.c -- loads a text .mem (one hex byte per line) into memory and runs fetch-decode-execute
 // Usage: ./cpu_loader_v2 program.mem
+//        ./cpu_loader_v2 program.obj   (binary object, mapped with mmap; see mem_obj.h)
 
 #include <stdio.h>
 #include <stdint.h>
@@ -7,19 +8,17 @@
 #include <string.h>
 #include <ctype.h>
 
-#define MEM_SIZE 256
-#define HALT 0xFF
+#include "isa.h"
+#include "mem_obj.h"
 
-#define LOAD  0x01
-#define ADD   0x02
-#define STORE 0x03
-#define JMP   0x04
-#define JZ    0x05
+#define MEM_SIZE 256
 
 // Memory and registers
 static uint8_t memory[MEM_SIZE];
 static uint8_t ACC = 0;   // Accumulator
 static uint8_t PC  = 0;   // Program Counter
+static uint8_t C   = 0;   // Carry flag (carry of ADD/ADC..., borrow of SUB/SBC...)
+static uint8_t X   = 0;   // Index register (LOADX/ADDX/STOREX)
 
 // Trim leading whitespace
 static char *ltrim(char *s) {
@@ -75,46 +74,215 @@ static int load_mem_from_file(const char *path) {
     return 1;
 }
 
+// Load a .obj file: segments are copied from the mapping straight into
+// memory[], PC starts at the object's entry point
+static int load_obj_from_file(const char *path) {
+    mem_obj_t obj;
+    if (mem_obj_map(&obj, path) != 0)
+        return 0;
+
+    mem_obj_load(&obj, memory);
+    PC = obj.entry;
+
+    mem_obj_unmap(&obj);
+    return 1;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+// One exec_ function per ISA_TABLE row, named after it; each returns 1 to
+// stop. fetch_decode_execute() builds its switch from the table, so a row
+// without its function does not compile (the parentheses around the
+// name rule out an implicit declaration).
+static int exec_NOP(void) {
+    return 0;
+}
+
+static int exec_LOAD(void) {
+    uint8_t addr = memory[PC++];
+    ACC = memory[addr];
+    return 0;
+}
+
+static int exec_ADD(void) {
+    uint8_t addr = memory[PC++];
+    unsigned sum = ACC + memory[addr];
+    ACC = (uint8_t)sum;
+    C = sum >> 8;         // carry out of bit 7
+    return 0;
+}
+
+static int exec_ADC(void) {
+    uint8_t addr = memory[PC++];
+    unsigned sum = ACC + memory[addr] + C;
+    ACC = (uint8_t)sum;
+    C = sum >> 8;
+    return 0;
+}
+
+static int exec_MUL(void) {
+    uint8_t addr = memory[PC++];
+    ACC = (uint8_t)(ACC * memory[addr]);   // low byte of the product
+    return 0;
+}
+
+static int exec_SUB(void) {
+    uint8_t addr = memory[PC++];
+    unsigned dif = ACC - memory[addr];
+    ACC = (uint8_t)dif;
+    C = (dif >> 8) & 1;   // borrow: the result went below 0
+    return 0;
+}
+
+static int exec_SBC(void) {
+    uint8_t addr = memory[PC++];
+    unsigned dif = ACC - memory[addr] - C;
+    ACC = (uint8_t)dif;
+    C = (dif >> 8) & 1;
+    return 0;
+}
+
+static int exec_LOADI(void) {
+    ACC = memory[PC++];
+    return 0;
+}
+
+static int exec_ADDI(void) {
+    unsigned sum = ACC + memory[PC++];
+    ACC = (uint8_t)sum;
+    C = sum >> 8;
+    return 0;
+}
+
+static int exec_SUBI(void) {
+    unsigned dif = ACC - memory[PC++];
+    ACC = (uint8_t)dif;
+    C = (dif >> 8) & 1;
+    return 0;
+}
+
+static int exec_STORE(void) {
+    uint8_t addr = memory[PC++];
+    memory[addr] = ACC;
+    return 0;
+}
+
+// Through a pointer: the operand is the address of the byte that holds
+// the data address
+static int exec_LOADP(void) {
+    uint8_t ptr = memory[PC++];
+    ACC = memory[memory[ptr]];
+    return 0;
+}
+
+static int exec_ADDP(void) {
+    uint8_t ptr = memory[PC++];
+    unsigned sum = ACC + memory[memory[ptr]];
+    ACC = (uint8_t)sum;
+    C = sum >> 8;
+    return 0;
+}
+
+static int exec_STOREP(void) {
+    uint8_t ptr = memory[PC++];
+    memory[memory[ptr]] = ACC;
+    return 0;
+}
+
+// Indexed: operand + X, wrapping at 256
+static int exec_LOADX(void) {
+    uint8_t base = memory[PC++];
+    ACC = memory[(uint8_t)(base + X)];
+    return 0;
+}
+
+static int exec_ADDX(void) {
+    uint8_t base = memory[PC++];
+    unsigned sum = ACC + memory[(uint8_t)(base + X)];
+    ACC = (uint8_t)sum;
+    C = sum >> 8;
+    return 0;
+}
+
+static int exec_STOREX(void) {
+    uint8_t base = memory[PC++];
+    memory[(uint8_t)(base + X)] = ACC;
+    return 0;
+}
+
+static int exec_INX(void) {
+    X++;
+    return 0;
+}
+
+static int exec_DEX(void) {
+    X--;
+    return 0;
+}
+
+static int exec_TAX(void) {
+    X = ACC;
+    return 0;
+}
+
+static int exec_TXA(void) {
+    ACC = X;
+    return 0;
+}
+
+static int exec_JMP(void) {
+    uint8_t addr = memory[PC++];
+    PC = addr;            // unconditional jump
+    return 0;
+}
+
+static int exec_JZ(void) {
+    uint8_t addr = memory[PC++];
+    if (ACC == 0) {       // jump if ACC == 0
+        PC = addr;
+    }
+    return 0;
+}
+
+static int exec_JNZ(void) {
+    uint8_t addr = memory[PC++];
+    if (ACC != 0) {       // jump if ACC != 0
+        PC = addr;
+    }
+    return 0;
+}
+
+static int exec_JC(void) {
+    uint8_t addr = memory[PC++];
+    if (C) {              // jump if the last add carried / sub borrowed
+        PC = addr;
+    }
+    return 0;
+}
+
+// Debug aid: same line as the engines in Export_week4
+static int exec_PRINT(void) {
+    printf("[CPU] ACC=%3u (0x%02X), PC=0x%02X\n", ACC, ACC, PC);
+    return 0;
+}
+
+static int exec_HALT(void) {
+    return 1;             // stop execution
+}
+
 // Fetch-decode-execute loop
 static void fetch_decode_execute(void) {
+#define LOADER_CASE(name, code, kind) \
+            case OP_##name: if ((exec_##name)()) return; break;
+
     for (;;) {
         uint8_t instr = memory[PC++];  // fetch and increment PC
 
         switch (instr) {
-            case LOAD: {
-                uint8_t addr = memory[PC++];
-                ACC = memory[addr];
-                break;
-            }
-
-            case ADD: {
-                uint8_t addr = memory[PC++];
-                ACC = (uint8_t)(ACC + memory[addr]);
-                break;
-            }
-
-            case STORE: {
-                uint8_t addr = memory[PC++];
-                memory[addr] = ACC;
-                break;
-            }
-
-            case JMP: {
-                uint8_t addr = memory[PC++];
-                PC = addr;            // unconditional jump
-                break;
-            }
-
-            case JZ: {
-                uint8_t addr = memory[PC++];
-                if (ACC == 0) {       // jump if ACC == 0
-                    PC = addr;
-                }
-                break;
-            }
-
-            case HALT:
-                return;               // stop execution
+            ISA_TABLE(LOADER_CASE)
 
             default:
                 printf("Unknown instruction %02X at PC=%02X\n",
@@ -122,27 +290,32 @@ static void fetch_decode_execute(void) {
                 return;
         }
     }
+#undef LOADER_CASE
 }
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        printf("Usage: %s program.mem\n", argv[0]);
-        return 1;
-    }
-
-    if (!load_mem_from_file(argv[1])) {
+        printf("Usage: %s program.mem|program.obj\n", argv[0]);
         return 1;
     }
 
     ACC = 0;
     PC  = 0;
+    C   = 0;
+    X   = 0;
+
+    int ok = ends_with(argv[1], ".obj") ? load_obj_from_file(argv[1])
+                                        : load_mem_from_file(argv[1]);
+    if (!ok) {
+        return 1;
+    }
 
     fetch_decode_execute();
 
     // After execution, show memory region 0x20..0x22 (legacy from suma example)
     printf("Memory snapshot (0x20..0x22): %02X %02X %02X\n",
            memory[0x20], memory[0x21], memory[0x22]);
-    printf("ACC=%02X PC=%02X\n", ACC, PC);
+    printf("ACC=%02X C=%u X=%02X PC=%02X\n", ACC, C, X, PC);
 
     return 0;
 }
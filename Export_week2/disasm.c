@@ -0,0 +1,250 @@
+// disasm.c -- disassembler: image -> assembler source
+//
+// Usage: ./disasm.x image.mem|.bin|.obj
+//
+// Prints a source file that assembler_v2 turns back into the same bytes.
+// Instructions are found by recursive descent from the entry point (PC 0
+// for .mem/.bin, the entry of a .obj, plus every symbol of a .obj that
+// points into code), following fall-through and jump targets; every other
+// byte is printed as .byte. Jump targets get a label: the symbol's name
+// if the .obj has one there, else L_xx (xx = address). Data operands
+// (pointers and index bases too) are named after a .obj symbol with that
+// value, if any. Each instruction line ends with its address and bytes
+// as a comment.
+//
+// A .mem/.bin image has no segments, so runs of 8 or more zero bytes are
+// taken as gaps (.org over them) rather than data.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "isa.h"
+#include "mem_obj.h"
+
+#define MEM_SIZE 256
+#define ZERO_GAP 8
+
+static uint8_t mem[MEM_SIZE];
+static uint8_t used[MEM_SIZE];      // byte belongs to the image
+static uint8_t reach[MEM_SIZE];     // an instruction is reached here
+static uint8_t insn[MEM_SIZE];      // printed as an instruction
+static uint8_t covered[MEM_SIZE];   // byte of a printed instruction
+static const char *name[MEM_SIZE];  // label printed at this address
+static const char *data_name[MEM_SIZE]; // symbol whose value is this address
+static char gen_name[MEM_SIZE][8];  // generated L_xx labels
+static int entry;
+static int is_obj;
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+// .mem: one hex byte per line. Returns the image length, -1 on error.
+static int load_mem(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[256];
+    int n = 0;
+    while (fgets(line, sizeof line, f)) {
+        char *p = line, *end;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+        long v = strtol(p, &end, 16);
+        if (end == p || n >= MEM_SIZE) {
+            fprintf(stderr, "%s: %s\n", path, end == p ? "invalid hex byte" : "more than 256 bytes");
+            fclose(f);
+            return -1;
+        }
+        mem[n++] = (uint8_t)v;
+    }
+    fclose(f);
+    return n;
+}
+
+// .bin: raw bytes from address 0. Returns the image length, -1 on error.
+static int load_bin(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    int n = (int)fread(mem, 1, MEM_SIZE, f);
+    fclose(f);
+    return n;
+}
+
+static void add_root(int a, int *work, int *top) {
+    if (a >= 0 && a < MEM_SIZE && used[a] && !reach[a]) {
+        reach[a] = 1;
+        work[(*top)++] = a;
+    }
+}
+
+// Recursive descent over the instructions reachable from the roots
+static void discover(int *work, int top) {
+    while (top > 0) {
+        int pc = work[--top];
+        uint8_t op = mem[pc], arg = mem[(uint8_t)(pc + 1)];
+        const isa_insn_t *in = isa_find(op);
+        if (!in || op == OP_HALT) continue;
+        if (in->kind == ISA_JUMP) add_root(arg, work, &top);
+        if (op != OP_JMP) add_root(pc + isa_insn_len(op), work, &top);
+    }
+}
+
+// Which reached addresses are printed as instructions: in address order,
+// one that starts inside a previous instruction (a jump into an operand)
+// or runs past the image stays data
+static void choose_insns(void) {
+    for (int a = 0; a < MEM_SIZE; a++) {
+        int len = isa_insn_len(mem[a]);
+        if (!reach[a] || covered[a] || !isa_find(mem[a]) || a + len > MEM_SIZE) continue;
+        if (len == 2 && !used[a + 1]) continue;
+        insn[a] = 1;
+        for (int k = 0; k < len; k++) covered[a + k] = 1;
+    }
+}
+
+static void print_label(int a) {
+    if (name[a]) printf("%s:\n", name[a]);
+}
+
+static void print_insn(int a) {
+    uint8_t op = mem[a], arg = mem[(uint8_t)(a + 1)];
+    const isa_insn_t *in = isa_find(op);
+    char text[40];
+    if (in->kind == ISA_JUMP && insn[arg] && name[arg])
+        snprintf(text, sizeof text, "%-5s %s", in->name, name[arg]);
+    else if (in->kind == ISA_ADDR && data_name[arg])
+        snprintf(text, sizeof text, "%-5s %s", in->name, data_name[arg]);
+    else if (in->kind == ISA_PTR && data_name[arg])
+        snprintf(text, sizeof text, "%-5s [%s]", in->name, data_name[arg]);
+    else if (in->kind == ISA_IDX && data_name[arg])
+        snprintf(text, sizeof text, "%-5s %s,X", in->name, data_name[arg]);
+    else
+        isa_disasm(text, sizeof text, mem, (uint8_t)a);
+
+    if (isa_insn_len(op) == 2)
+        printf("        %-22s ; %02X  %02X %02X\n", text, a, op, arg);
+    else
+        printf("        %-22s ; %02X  %02X\n", text, a, op);
+}
+
+// .byte lines for the data bytes [a, end): a new line at every label and
+// every 8 bytes
+static void print_data(int a, int end) {
+    while (a < end) {
+        print_label(a);
+        printf("        .byte ");
+        int n = 0;
+        do {
+            printf("%s0x%02X", n ? ", " : "", mem[a]);
+            a++, n++;
+        } while (a < end && n < 8 && !name[a]);
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s image.mem|.bin|.obj\n", argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    int work[MEM_SIZE], top = 0;
+    mem_obj_t obj;
+
+    is_obj = ends_with(path, ".obj");
+    if (is_obj) {
+        if (mem_obj_map(&obj, path) != 0) return 1;
+        mem_obj_load(&obj, mem);
+        for (int s = 0; s < obj.nsegs; s++) {
+            uint8_t addr;
+            int len;
+            mem_obj_segment(&obj, s, &addr, &len);
+            memset(used + addr, 1, (size_t)len);
+        }
+        entry = obj.entry;
+    } else {
+        int n = ends_with(path, ".bin") ? load_bin(path) : load_mem(path);
+        if (n < 0) return 1;
+        memset(used, 1, (size_t)n);
+    }
+
+    add_root(entry, work, &top);
+    if (is_obj) {
+        for (int i = 0; i < obj.nsyms; i++) {
+            uint8_t v;
+            const char *sname = mem_obj_symbol(&obj, i, &v);
+            uint8_t flags = mem_obj_symbol_flags(&obj, i), seg = mem_obj_symbol_seg(&obj, i);
+            if (flags & (MEM_OBJ_SYM_EXTERN | MEM_OBJ_SYM_ABS)) continue;
+            if (!name[v]) name[v] = sname;
+            if (!data_name[v]) data_name[v] = sname;
+            if (seg != MEM_OBJ_NO_SEG && (mem_obj_segment_flags(&obj, seg) & MEM_OBJ_SEG_CODE))
+                add_root(v, work, &top);
+        }
+    }
+    discover(work, top);
+    choose_insns();
+
+    if (!is_obj) {
+        // runs of ZERO_GAP or more zeros outside code are gaps, except the
+        // last byte of the image (it keeps the length of the .mem)
+        int last = MEM_SIZE - 1;
+        while (last > 0 && !used[last]) last--;
+        for (int a = 0; a <= last; ) {
+            int z = a;
+            while (z <= last && mem[z] == 0 && !covered[z]) z++;
+            if (z - a >= ZERO_GAP) memset(used + a, 0, (size_t)(z > last ? last - a : z - a));
+            a = z > a ? z : a + 1;
+        }
+    }
+
+    // labels for the jump targets (and the entry) that have no name
+    for (int a = 0; a < MEM_SIZE; a++) {
+        uint8_t op = mem[a], t = mem[(uint8_t)(a + 1)];
+        if (!insn[a] || isa_kind(op) != ISA_JUMP || !insn[t] || name[t]) continue;
+        snprintf(gen_name[t], sizeof gen_name[t], "L_%02X", t);
+        name[t] = gen_name[t];
+    }
+    if (entry != 0 && insn[entry] && !name[entry]) {
+        snprintf(gen_name[entry], sizeof gen_name[entry], "L_%02X", entry);
+        name[entry] = gen_name[entry];
+    }
+    // names only for addresses that get their label line
+    for (int a = 0; a < MEM_SIZE; a++)
+        if (!used[a] || (covered[a] && !insn[a])) data_name[a] = NULL;
+
+    printf("; %s, disassembled (entry 0x%02X)\n", path, entry);
+    if (entry != 0 && name[entry]) printf("        .entry %s\n", name[entry]);
+
+    int pc = -1;            // where the assembler would emit next
+    for (int a = 0; a < MEM_SIZE; ) {
+        if (!used[a]) {
+            a++;
+            continue;
+        }
+        if (pc != a) printf("        .org 0x%02X\n", a);
+        if (insn[a]) {
+            print_label(a);
+            print_insn(a);
+            a += isa_insn_len(mem[a]);
+        } else {
+            int end = a;
+            while (end < MEM_SIZE && used[end] && !insn[end]) end++;
+            print_data(a, end);
+            a = end;
+        }
+        pc = a;
+    }
+
+    if (is_obj) mem_obj_unmap(&obj);
+    return 0;
+}
@@ -0,0 +1,207 @@
+// isa.h -- the instruction set of the 8-bit accumulator CPU, defined once
+//
+// ISA_TABLE has one row per instruction: its name (which is also its
+// mnemonic), opcode and operand kind. Everything that has to know the
+// ISA expands it instead of keeping a list of its own:
+//   - the opcode enums: OP_* below (assembler, loader, disassembler) and
+//     the bare NOP/LOAD/... names of Export_week4/cpu_core.h;
+//   - instruction lengths (isa_insn_len) and operand kinds (isa_kind);
+//   - the dispatch tables of the interpreters (Export_week4/cpu_exec.h)
+//     and the switch of cpu_loader_v2.c, where a row without a handler
+//     is a compile error;
+//   - the mnemonic lookup of the assembler (isa_hash_*);
+//   - the disassembler (isa_disasm, disasm.c).
+// Adding an instruction is one row here plus its semantics in each
+// engine.
+//
+// Operand kinds (every instruction with an operand is 2 bytes):
+//   ISA_NONE   no operand                      HALT
+//   ISA_ADDR   address of a data byte          LOAD 0xC0
+//   ISA_JUMP   address of an instruction       JZ   0x14
+//   ISA_IMM    the value itself                LOADI #1
+//   ISA_PTR    address of a byte that holds    LOADP [0xC0]
+//              the address of the data
+//   ISA_IDX    address of a data byte, plus X  LOADX 0xC0,X
+//
+// Carry flag C: every addition (ADD, ADDI, ADC) sets it to the carry out
+// of bit 7 and every subtraction (SUB, SUBI, SBC) to the borrow (1 if the
+// result went below 0), as x86 does. Nothing else touches it; it is 0
+// after a reset. A 16-bit sum of little-endian X and Y into Z:
+//   LOAD X ; ADD Y ; STORE Z ; LOAD X+1 ; ADC Y+1 ; STORE Z+1
+//
+// Index register X: 8 bits, 0 after a reset; only INX, DEX and TAX change
+// it and none of them touches C. Pointer and index arithmetic wrap at 256
+// like the PC: LOADX 0xF0,X with X = 0x20 reads 0x10. Together they walk
+// a table without rewriting the operand of an instruction, e.g. a sum of
+// the LEN bytes at TABLE:
+//   LOADI 0 ; STORE SUM ; TAX
+//   LOOP: LOAD SUM ; ADD TABLE,X ; STORE SUM ; INX ; TXA ; SUB LEN ; JNZ LOOP
+//
+// Header-only, like mem_obj.h, so the tools in this folder and the
+// drivers in Export_week4 share one definition.
+
+#ifndef ISA_H
+#define ISA_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <ctype.h>
+
+enum { ISA_NONE, ISA_ADDR, ISA_JUMP, ISA_IMM, ISA_PTR, ISA_IDX };
+
+//      name   opcode  operand        semantics
+#define ISA_TABLE(X) \
+    X(NOP,    0x00, ISA_NONE)  /* no operation                          */ \
+    X(LOAD,   0x01, ISA_ADDR)  /* ACC <- [addr]                         */ \
+    X(ADD,    0x02, ISA_ADDR)  /* ACC <- ACC + [addr]       C <- carry  */ \
+    X(STORE,  0x03, ISA_ADDR)  /* [addr] <- ACC                         */ \
+    X(JMP,    0x04, ISA_JUMP)  /* PC <- addr                            */ \
+    X(JZ,     0x05, ISA_JUMP)  /* if ACC == 0 then PC <- addr           */ \
+    X(PRINT,  0x06, ISA_NONE)  /* debug: print ACC and PC               */ \
+    X(MUL,    0x07, ISA_ADDR)  /* ACC <- ACC * [addr]   (low byte)      */ \
+    X(SUB,    0x08, ISA_ADDR)  /* ACC <- ACC - [addr]       C <- borrow */ \
+    X(JNZ,    0x09, ISA_JUMP)  /* if ACC != 0 then PC <- addr           */ \
+    X(LOADI,  0x0A, ISA_IMM)   /* ACC <- imm                            */ \
+    X(ADDI,   0x0B, ISA_IMM)   /* ACC <- ACC + imm          C <- carry  */ \
+    X(SUBI,   0x0C, ISA_IMM)   /* ACC <- ACC - imm          C <- borrow */ \
+    X(ADC,    0x0D, ISA_ADDR)  /* ACC <- ACC + [addr] + C   C <- carry  */ \
+    X(SBC,    0x0E, ISA_ADDR)  /* ACC <- ACC - [addr] - C   C <- borrow */ \
+    X(JC,     0x0F, ISA_JUMP)  /* if C then PC <- addr                  */ \
+    X(LOADP,  0x10, ISA_PTR)   /* ACC <- [[ptr]]                        */ \
+    X(ADDP,   0x11, ISA_PTR)   /* ACC <- ACC + [[ptr]]      C <- carry  */ \
+    X(STOREP, 0x12, ISA_PTR)   /* [[ptr]] <- ACC                        */ \
+    X(LOADX,  0x13, ISA_IDX)   /* ACC <- [addr + X]                     */ \
+    X(ADDX,   0x14, ISA_IDX)   /* ACC <- ACC + [addr + X]   C <- carry  */ \
+    X(STOREX, 0x15, ISA_IDX)   /* [addr + X] <- ACC                     */ \
+    X(INX,    0x16, ISA_NONE)  /* X <- X + 1                            */ \
+    X(DEX,    0x17, ISA_NONE)  /* X <- X - 1                            */ \
+    X(TAX,    0x18, ISA_NONE)  /* X <- ACC                              */ \
+    X(TXA,    0x19, ISA_NONE)  /* ACC <- X                              */ \
+    X(HALT,   0xFF, ISA_NONE)  /* stop                                  */
+
+#define ISA_OPCODE(name, code, kind)  OP_##name = code,
+enum { ISA_TABLE(ISA_OPCODE) };
+#undef ISA_OPCODE
+
+// Row numbers, and the rows themselves in table order
+#define ISA_INDEX(name, code, kind)   ISA_I_##name,
+enum { ISA_TABLE(ISA_INDEX) ISA_COUNT };
+#undef ISA_INDEX
+
+typedef struct {
+    const char *name;
+    uint8_t opcode;
+    uint8_t kind;       // ISA_*
+} isa_insn_t;
+
+#define ISA_ROW(name, code, kind)     { #name, code, kind },
+static const isa_insn_t isa_insns[ISA_COUNT] = { ISA_TABLE(ISA_ROW) };
+#undef ISA_ROW
+
+// Row of opcode op, NULL if op is not an instruction
+static inline const isa_insn_t *isa_find(uint8_t op) {
+#define ISA_CASE(name, code, kind)    case code: return &isa_insns[ISA_I_##name];
+    switch (op) {
+    ISA_TABLE(ISA_CASE)
+    default: return NULL;
+    }
+#undef ISA_CASE
+}
+
+static inline int isa_kind(uint8_t op) {
+    const isa_insn_t *in = isa_find(op);
+    return in ? in->kind : ISA_NONE;
+}
+
+// Bytes of the instruction: 2 if it has an operand, else 1 (also for an
+// unknown opcode)
+static inline int isa_insn_len(uint8_t op) {
+    return isa_kind(op) == ISA_NONE ? 1 : 2;
+}
+
+// ---------------------------------------------------------------------
+// Mnemonic lookup: a perfect hash built from the table
+//
+// isa_hash_init() tries seeds until no two mnemonics share a slot, so a
+// lookup hashes the token once, reads one slot and compares one string
+// whatever the size of the ISA. The search takes a handful of tries and
+// its result only depends on the table.
+// ---------------------------------------------------------------------
+#define ISA_HASH_SLOTS  128     // power of 2, a few times ISA_COUNT
+
+typedef struct {
+    uint32_t seed;
+    int8_t   slot[ISA_HASH_SLOTS];  // row in isa_insns, -1 = empty
+} isa_hash_t;
+
+// FNV-1a of the case-folded name, mixed with seed; *len = its length
+static inline uint32_t isa_hash_name(const char *s, uint32_t seed, size_t *len) {
+    uint32_t h = 2166136261u ^ seed;
+    size_t n = 0;
+    for (; s[n]; n++) {
+        h ^= (uint8_t)toupper((unsigned char)s[n]);
+        h *= 16777619u;
+    }
+    *len = n;
+    return h ^ (h >> 15);
+}
+
+// Returns 0, or -1 if no seed separates the mnemonics (a table too big
+// for ISA_HASH_SLOTS)
+static inline int isa_hash_init(isa_hash_t *t) {
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        int ok = 1;
+        for (int k = 0; k < ISA_HASH_SLOTS; k++) t->slot[k] = -1;
+        for (int i = 0; i < ISA_COUNT && ok; i++) {
+            size_t n;
+            uint32_t s = isa_hash_name(isa_insns[i].name, seed, &n) & (ISA_HASH_SLOTS - 1);
+            if (t->slot[s] >= 0) ok = 0;
+            else t->slot[s] = (int8_t)i;
+        }
+        if (ok) {
+            t->seed = seed;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Opcode of mnemonic tok (any case), -1 if it is not one
+static inline int isa_hash_lookup(const isa_hash_t *t, const char *tok) {
+    size_t n;
+    uint32_t s = isa_hash_name(tok, t->seed, &n) & (ISA_HASH_SLOTS - 1);
+    if (t->slot[s] < 0) return -1;
+    const isa_insn_t *in = &isa_insns[t->slot[s]];
+    for (size_t i = 0; i <= n; i++)
+        if (toupper((unsigned char)tok[i]) != in->name[i]) return -1;
+    return in->opcode;
+}
+
+// ---------------------------------------------------------------------
+// Disassembler
+// ---------------------------------------------------------------------
+// Writes the instruction at pc as assembler source ("LOAD 0xC0",
+// "JZ 0x14", "LOADI #1", "LOADP [0xC0]", "LOADX 0xC0,X", "HALT";
+// ".byte 0x42" if the opcode is unknown)
+// and returns its length in bytes. The operand is mem[pc+1], wrapping
+// at the end of memory as the CPU does.
+static inline int isa_disasm(char *buf, size_t size, const uint8_t mem[256], uint8_t pc) {
+    uint8_t op = mem[pc], arg = mem[(uint8_t)(pc + 1)];
+    const isa_insn_t *in = isa_find(op);
+    if (!in)
+        snprintf(buf, size, ".byte 0x%02X", op);
+    else if (in->kind == ISA_NONE)
+        snprintf(buf, size, "%s", in->name);
+    else if (in->kind == ISA_IMM)
+        snprintf(buf, size, "%-5s #%u", in->name, arg);
+    else if (in->kind == ISA_PTR)
+        snprintf(buf, size, "%-5s [0x%02X]", in->name, arg);
+    else if (in->kind == ISA_IDX)
+        snprintf(buf, size, "%-5s 0x%02X,X", in->name, arg);
+    else
+        snprintf(buf, size, "%-5s 0x%02X", in->name, arg);
+    return in ? isa_insn_len(op) : 1;
+}
+
+#endif // ISA_H
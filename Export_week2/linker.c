@@ -0,0 +1,265 @@
+// linker.c -- packs several relocatable .obj modules into one image
+//
+// Usage: ./linker.x -o out.obj [-e SYMBOL] [-d DATA_ADDR] module.obj...
+//
+// Every module must be relocatable (assembled from a source that uses
+// .global / .extern, see mem_obj.h). The linker
+//   - places the code segments of all modules one after another from
+//     address 0, in command-line order, and the data segments after the
+//     last code byte (or from DATA_ADDR with -d);
+//   - resolves each .extern against the .global symbols of the other
+//     modules (a global defined twice, or an extern nobody defines, is an
+//     error);
+//   - patches every relocated byte with the final symbol value;
+//   - writes an absolute .obj holding only the global symbols, with the
+//     entry PC of SYMBOL (-e) or else the first module's entry.
+// A link map (where each segment went) is printed on stdout.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_obj.h"
+
+typedef struct {
+    const char *path;
+    mem_obj_t   obj;
+    int         base[MEM_OBJ_MEM_SIZE];     // final address of each segment
+} module_t;
+
+typedef struct {
+    const char *name;
+    uint8_t     value;
+    int         module;
+} global_t;
+
+static module_t *mods;
+static int nmods;
+static global_t *globals;
+static int nglobals;
+
+static int cmp_globals(const void *a, const void *b) {
+    return strcmp(((const global_t *)a)->name, ((const global_t *)b)->name);
+}
+
+static const global_t *find_global(const char *name) {
+    global_t key = { name, 0, 0 };
+    return bsearch(&key, globals, (size_t)nglobals, sizeof(global_t), cmp_globals);
+}
+
+// Final address of module address a (which must lie in a segment), -1 if
+// no segment holds it
+static int relocate_addr(const module_t *m, uint8_t a) {
+    for (int s = 0; s < m->obj.nsegs; s++) {
+        uint8_t addr;
+        int len;
+        mem_obj_segment(&m->obj, s, &addr, &len);
+        if (a >= addr && a < addr + len) return m->base[s] + (a - addr);
+    }
+    return -1;
+}
+
+// Final value of symbol i of module m (externs through the global table)
+static int symbol_value(const module_t *m, int i) {
+    uint8_t v;
+    const char *name = mem_obj_symbol(&m->obj, i, &v);
+
+    if (mem_obj_symbol_flags(&m->obj, i) & MEM_OBJ_SYM_EXTERN) {
+        const global_t *g = find_global(name);
+        if (!g) {
+            fprintf(stderr, "%s: undefined external symbol %s\n", m->path, name);
+            return -1;
+        }
+        return g->value;
+    }
+    uint8_t seg = mem_obj_symbol_seg(&m->obj, i);
+    if (seg == MEM_OBJ_NO_SEG) return v;
+
+    uint8_t addr;
+    int len;
+    mem_obj_segment(&m->obj, seg, &addr, &len);
+    return m->base[seg] + (v - addr);
+}
+
+// Assign the final address of every segment: code first, then data
+static int layout(int data_base) {
+    int pc = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        int want = pass == 0 ? MEM_OBJ_SEG_CODE : 0;
+        if (pass == 1 && data_base >= 0) {
+            if (data_base < pc) {
+                fprintf(stderr, "linker: data at 0x%02X would overlap code (ends at 0x%02X)\n",
+                        data_base, pc);
+                return -1;
+            }
+            pc = data_base;
+        }
+        for (int k = 0; k < nmods; k++) {
+            module_t *m = &mods[k];
+            for (int s = 0; s < m->obj.nsegs; s++) {
+                if ((mem_obj_segment_flags(&m->obj, s) & MEM_OBJ_SEG_CODE) != want) continue;
+                uint8_t addr;
+                int len;
+                mem_obj_segment(&m->obj, s, &addr, &len);
+                if (pc + len > MEM_OBJ_MEM_SIZE) {
+                    fprintf(stderr, "linker: the modules do not fit in %d bytes\n",
+                            MEM_OBJ_MEM_SIZE);
+                    return -1;
+                }
+                m->base[s] = pc;
+                printf("  %-24s %s 0x%02X..0x%02X -> 0x%02X\n", m->path,
+                       want ? "code" : "data", addr, addr + len - 1, pc);
+                pc += len;
+            }
+        }
+    }
+    return 0;
+}
+
+static int collect_globals(void) {
+    int cap = 0;
+    for (int k = 0; k < nmods; k++) cap += mods[k].obj.nsyms;
+    globals = malloc(sizeof(global_t) * (size_t)(cap ? cap : 1));
+    if (!globals) {
+        perror("linker");
+        return -1;
+    }
+
+    for (int k = 0; k < nmods; k++) {
+        const module_t *m = &mods[k];
+        for (int i = 0; i < m->obj.nsyms; i++) {
+            uint8_t f = mem_obj_symbol_flags(&m->obj, i);
+            if (!(f & MEM_OBJ_SYM_GLOBAL) || (f & MEM_OBJ_SYM_EXTERN)) continue;
+            uint8_t v;
+            globals[nglobals].name   = mem_obj_symbol(&m->obj, i, &v);
+            globals[nglobals].value  = (uint8_t)symbol_value(m, i);
+            globals[nglobals].module = k;
+            nglobals++;
+        }
+    }
+    qsort(globals, (size_t)nglobals, sizeof(global_t), cmp_globals);
+
+    for (int i = 1; i < nglobals; i++) {
+        if (strcmp(globals[i - 1].name, globals[i].name) == 0) {
+            fprintf(stderr, "linker: global %s defined in %s and %s\n", globals[i].name,
+                    mods[globals[i - 1].module].path, mods[globals[i].module].path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *out = NULL, *entry_sym = NULL;
+    int data_base = -1;
+
+    mods = calloc((size_t)argc, sizeof(module_t));
+    if (!mods) {
+        perror("linker");
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            entry_sym = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            data_base = (int)strtol(argv[++i], NULL, 0);
+            if (data_base < 0 || data_base >= MEM_OBJ_MEM_SIZE) {
+                fprintf(stderr, "linker: -d must be 0..0x%02X\n", MEM_OBJ_MEM_SIZE - 1);
+                return 1;
+            }
+        } else {
+            mods[nmods++].path = argv[i];
+        }
+    }
+    if (!out || nmods == 0) {
+        fprintf(stderr, "Usage: %s -o out.obj [-e SYMBOL] [-d DATA_ADDR] module.obj...\n",
+                argv[0]);
+        return 1;
+    }
+
+    for (int k = 0; k < nmods; k++) {
+        if (mem_obj_map(&mods[k].obj, mods[k].path) != 0) return 1;
+        if (!(mods[k].obj.flags & MEM_OBJ_RELOCATABLE)) {
+            fprintf(stderr, "%s: not relocatable (assemble it with .global/.extern symbols)\n",
+                    mods[k].path);
+            return 1;
+        }
+    }
+
+    printf("Link map:\n");
+    if (layout(data_base) != 0 || collect_globals() != 0) return 1;
+
+    // Copy the segments to their final place, then patch the relocations
+    uint8_t mem[MEM_OBJ_MEM_SIZE] = { 0 }, used[MEM_OBJ_MEM_SIZE] = { 0 };
+    uint8_t code[MEM_OBJ_MEM_SIZE] = { 0 };
+    for (int k = 0; k < nmods; k++) {
+        const module_t *m = &mods[k];
+        for (int s = 0; s < m->obj.nsegs; s++) {
+            uint8_t addr;
+            int len;
+            const uint8_t *bytes = mem_obj_segment(&m->obj, s, &addr, &len);
+            int is_code = mem_obj_segment_flags(&m->obj, s) & MEM_OBJ_SEG_CODE;
+            memcpy(mem + m->base[s], bytes, (size_t)len);
+            memset(used + m->base[s], 1, (size_t)len);
+            memset(code + m->base[s], is_code ? 1 : 0, (size_t)len);
+        }
+        for (int i = 0; i < m->obj.nrelocs; i++) {
+            uint8_t at;
+            int sym = mem_obj_reloc(&m->obj, i, &at);
+            int where = relocate_addr(m, at), value = symbol_value(m, sym);
+            if (value < 0) return 1;
+            if (where < 0) {
+                fprintf(stderr, "%s: relocation at 0x%02X outside every segment\n", m->path, at);
+                return 1;
+            }
+            mem[where] = (uint8_t)value;
+        }
+    }
+
+    int entry;
+    if (entry_sym) {
+        const global_t *g = find_global(entry_sym);
+        if (!g) {
+            fprintf(stderr, "linker: entry symbol %s is not a global\n", entry_sym);
+            return 1;
+        }
+        entry = g->value;
+    } else {
+        entry = relocate_addr(&mods[0], mods[0].obj.entry);
+        if (entry < 0) entry = mods[0].obj.entry;
+    }
+
+    mem_obj_symdef_t *defs = malloc(sizeof(mem_obj_symdef_t) * (size_t)(nglobals ? nglobals : 1));
+    if (!defs) {
+        perror("linker");
+        return 1;
+    }
+    for (int i = 0; i < nglobals; i++) {
+        defs[i].name  = globals[i].name;
+        defs[i].value = globals[i].value;
+        defs[i].flags = MEM_OBJ_SYM_GLOBAL;
+    }
+    mem_obj_out_t obj = {
+        .mem = mem, .used = used, .code = code,
+        .entry = (uint8_t)entry, .flags = 0,
+        .syms = defs, .nsyms = nglobals,
+    };
+    if (mem_obj_write(out, &obj) != 0) {
+        perror(out);
+        return 1;
+    }
+
+    int last = 0;
+    for (int a = 0; a < MEM_OBJ_MEM_SIZE; a++) if (used[a]) last = a;
+    printf("Linked %d module%s -> %s (0x%02X bytes, entry 0x%02X, %d globals)\n",
+           nmods, nmods == 1 ? "" : "s", out, last + 1, entry, nglobals);
+
+    free(defs);
+    free(globals);
+    for (int k = 0; k < nmods; k++) mem_obj_unmap(&mods[k].obj);
+    free(mods);
+    return 0;
+}
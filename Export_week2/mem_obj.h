@@ -0,0 +1,419 @@
+// mem_obj.h -- binary object format written by assembler_v2 and linker (.obj)
+//
+// A .mem / .bin image is a dump of memory from address 0 to the last used
+// byte, so a program with code at 0x00 and data at 0xC0 carries ~150 zero
+// bytes of padding, and .mem must be parsed byte by byte. A .obj stores
+// only the bytes that were emitted, grouped in load segments, plus the
+// entry PC and the symbol table, in a layout that is used straight from
+// an mmap() of the file (no parsing, no intermediate buffer: loading is
+// one memcpy per segment from the page cache into guest memory).
+//
+// A module that declares .global or .extern symbols is relocatable
+// (MEM_OBJ_RELOCATABLE): each segment can be moved, and every operand or
+// .byte that names a label or an extern has a relocation, so the linker
+// can place several modules in one image. Loaded as is, a relocatable
+// object is still the absolute image it was assembled as.
+//
+// Layout, version 2 (all multi-byte fields little endian):
+//
+//   header    16 bytes
+//     0  char[4]  magic "M8OB"
+//     4  u8       version (MEM_OBJ_VERSION)
+//     5  u8       entry PC
+//     6  u8       number of segments
+//     7  u8       flags (MEM_OBJ_RELOCATABLE)
+//     8  u16      number of symbols
+//    10  u16      string table size in bytes
+//    12  u16      number of relocations
+//    14  u16      reserved (0)
+//   segments  8 bytes each
+//     0  u8       load address
+//     1  u8       flags (MEM_OBJ_SEG_CODE: holds instructions)
+//     2  u16      length (1..256, addr + length <= 256)
+//     4  u32      file offset of the bytes
+//   symbols   6 bytes each, sorted by name
+//     0  u16      name: offset into the string table
+//     2  u8       value
+//     3  u8       flags (MEM_OBJ_SYM_*)
+//     4  u8       segment the value points into, 0xFF if none
+//     5  u8       reserved (0)
+//   relocations  4 bytes each
+//     0  u8       address of the byte to patch
+//     1  u8       reserved (0)
+//     2  u16      symbol whose final value goes there
+//   string table (NUL-terminated names), then the segment bytes.
+//
+// Version 1 (still read) had a 12-byte header without the relocation
+// count and 4-byte symbols without segment; nothing in it is relocatable.
+//
+// Header-only so the single-file tools in this folder and the drivers in
+// Export_week4 share one definition. Needs POSIX mmap.
+
+#ifndef MEM_OBJ_H
+#define MEM_OBJ_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MEM_OBJ_MAGIC    "M8OB"
+#define MEM_OBJ_VERSION  2
+#define MEM_OBJ_MEM_SIZE 256
+
+#define MEM_OBJ_HEADER_SIZE  16
+#define MEM_OBJ_SEG_SIZE     8
+#define MEM_OBJ_SYM_SIZE     6
+#define MEM_OBJ_RELOC_SIZE   4
+
+#define MEM_OBJ_V1_HEADER_SIZE  12
+#define MEM_OBJ_V1_SYM_SIZE     4
+
+#define MEM_OBJ_RELOCATABLE  0x01   // header flags
+#define MEM_OBJ_SEG_CODE     0x01   // segment flags
+#define MEM_OBJ_SYM_GLOBAL   0x01   // symbol flags: visible to other modules
+#define MEM_OBJ_SYM_EXTERN   0x02   //   defined in another module (value 0)
+#define MEM_OBJ_SYM_ABS      0x04   //   .equ constant, never relocated
+#define MEM_OBJ_NO_SEG       0xFF
+
+typedef struct {
+    const uint8_t *base;        // mapping of the whole file
+    size_t         size;
+    uint8_t        version;
+    uint8_t        entry;
+    uint8_t        flags;
+    int            nsegs;
+    int            nsyms;
+    int            nrelocs;
+    size_t         sym_size;    // bytes per symbol entry (depends on version)
+    const uint8_t *segs;        // segment table
+    const uint8_t *syms;        // symbol table
+    const uint8_t *relocs;      // relocation table
+    const char    *strtab;
+    size_t         strtab_len;
+} mem_obj_t;
+
+static inline uint16_t mem_obj_rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t mem_obj_rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void mem_obj_wr16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void mem_obj_wr32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void mem_obj_unmap(mem_obj_t *o) {
+    if (o->base) munmap((void *)o->base, o->size);
+    o->base = NULL;
+}
+
+// Map fname and check every table against the file size, so the
+// accessors below never read outside the mapping. Returns 0, or -1 after
+// reporting why.
+static inline int mem_obj_map(mem_obj_t *o, const char *fname) {
+    memset(o, 0, sizeof *o);
+
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+        perror(fname);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(fname);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size < MEM_OBJ_V1_HEADER_SIZE) {
+        fprintf(stderr, "%s: not an object file (too short)\n", fname);
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(fname);
+        return -1;
+    }
+    o->base = p;
+    o->size = (size_t)st.st_size;
+
+    const uint8_t *h = o->base;
+    if (memcmp(h, MEM_OBJ_MAGIC, 4) != 0) {
+        fprintf(stderr, "%s: not an object file (bad magic)\n", fname);
+        mem_obj_unmap(o);
+        return -1;
+    }
+    o->version = h[4];
+    if (o->version != 1 && o->version != MEM_OBJ_VERSION) {
+        fprintf(stderr, "%s: object format version %u, expected 1..%u\n",
+                fname, o->version, MEM_OBJ_VERSION);
+        mem_obj_unmap(o);
+        return -1;
+    }
+    o->entry      = h[5];
+    o->nsegs      = h[6];
+    o->nsyms      = mem_obj_rd16(h + 8);
+    o->strtab_len = mem_obj_rd16(h + 10);
+
+    size_t off;
+    if (o->version == 1) {
+        o->sym_size = MEM_OBJ_V1_SYM_SIZE;
+        off = MEM_OBJ_V1_HEADER_SIZE;
+    } else if (o->size < MEM_OBJ_HEADER_SIZE) {
+        fprintf(stderr, "%s: corrupt object file (short header)\n", fname);
+        mem_obj_unmap(o);
+        return -1;
+    } else {
+        o->flags    = h[7];
+        o->nrelocs  = mem_obj_rd16(h + 12);
+        o->sym_size = MEM_OBJ_SYM_SIZE;
+        off = MEM_OBJ_HEADER_SIZE;
+    }
+    o->segs   = o->base + off;
+    off      += (size_t)o->nsegs * MEM_OBJ_SEG_SIZE;
+    o->syms   = o->base + off;
+    off      += (size_t)o->nsyms * o->sym_size;
+    o->relocs = o->base + off;
+    off      += (size_t)o->nrelocs * MEM_OBJ_RELOC_SIZE;
+    o->strtab = (const char *)o->base + off;
+    off      += o->strtab_len;
+
+    const char *bad = NULL;
+    if (off > o->size) {
+        bad = "tables past end of file";
+    } else if (o->strtab_len > 0 && o->strtab[o->strtab_len - 1] != 0) {
+        bad = "unterminated string table";
+    }
+    for (int i = 0; !bad && i < o->nsegs; i++) {
+        const uint8_t *s = o->segs + i * MEM_OBJ_SEG_SIZE;
+        uint32_t len = mem_obj_rd16(s + 2), at = mem_obj_rd32(s + 4);
+        if (len == 0 || s[0] + len > MEM_OBJ_MEM_SIZE)
+            bad = "segment outside memory";
+        else if (at > o->size || len > o->size - at)
+            bad = "segment past end of file";
+    }
+    for (int i = 0; !bad && i < o->nsyms; i++) {
+        const uint8_t *s = o->syms + i * o->sym_size;
+        if (mem_obj_rd16(s) >= o->strtab_len)
+            bad = "symbol name outside string table";
+        else if (o->version > 1 && s[4] != MEM_OBJ_NO_SEG && s[4] >= o->nsegs)
+            bad = "symbol in a missing segment";
+    }
+    for (int i = 0; !bad && i < o->nrelocs; i++) {
+        if (mem_obj_rd16(o->relocs + i * MEM_OBJ_RELOC_SIZE + 2) >= o->nsyms)
+            bad = "relocation of a missing symbol";
+    }
+    if (bad) {
+        fprintf(stderr, "%s: corrupt object file (%s)\n", fname, bad);
+        mem_obj_unmap(o);
+        return -1;
+    }
+    return 0;
+}
+
+// Segment i: load address, length, and its bytes inside the mapping
+static inline const uint8_t *mem_obj_segment(const mem_obj_t *o, int i,
+                                             uint8_t *addr, int *len) {
+    const uint8_t *s = o->segs + i * MEM_OBJ_SEG_SIZE;
+    *addr = s[0];
+    *len  = mem_obj_rd16(s + 2);
+    return o->base + mem_obj_rd32(s + 4);
+}
+
+static inline uint8_t mem_obj_segment_flags(const mem_obj_t *o, int i) {
+    return o->segs[i * MEM_OBJ_SEG_SIZE + 1];
+}
+
+// Zero mem[] and copy every segment into place. Returns one past the
+// highest loaded address (the length a .mem of the same program has).
+static inline int mem_obj_load(const mem_obj_t *o, uint8_t mem[MEM_OBJ_MEM_SIZE]) {
+    int end = 0;
+    memset(mem, 0, MEM_OBJ_MEM_SIZE);
+    for (int i = 0; i < o->nsegs; i++) {
+        uint8_t addr;
+        int len;
+        const uint8_t *bytes = mem_obj_segment(o, i, &addr, &len);
+        memcpy(mem + addr, bytes, (size_t)len);
+        if (addr + len > end) end = addr + len;
+    }
+    return end;
+}
+
+// Symbol i: returns its name and stores its value
+static inline const char *mem_obj_symbol(const mem_obj_t *o, int i, uint8_t *value) {
+    const uint8_t *s = o->syms + i * o->sym_size;
+    *value = s[2];
+    return o->strtab + mem_obj_rd16(s);
+}
+
+static inline uint8_t mem_obj_symbol_flags(const mem_obj_t *o, int i) {
+    return o->version > 1 ? o->syms[i * o->sym_size + 3] : 0;
+}
+
+// Segment the value of symbol i points into, MEM_OBJ_NO_SEG if none
+static inline uint8_t mem_obj_symbol_seg(const mem_obj_t *o, int i) {
+    return o->version > 1 ? o->syms[i * o->sym_size + 4] : MEM_OBJ_NO_SEG;
+}
+
+// Relocation i: returns the symbol index and stores the address to patch
+static inline int mem_obj_reloc(const mem_obj_t *o, int i, uint8_t *addr) {
+    const uint8_t *r = o->relocs + i * MEM_OBJ_RELOC_SIZE;
+    *addr = r[0];
+    return mem_obj_rd16(r + 2);
+}
+
+// Value of the symbol called name, or -1 if the object has no such
+// symbol (or only declares it .extern)
+static inline int mem_obj_find(const mem_obj_t *o, const char *name) {
+    int lo = 0, hi = o->nsyms - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint8_t v;
+        int c = strcmp(mem_obj_symbol(o, mid, &v), name);
+        if (c == 0) return (mem_obj_symbol_flags(o, mid) & MEM_OBJ_SYM_EXTERN) ? -1 : v;
+        if (c < 0) lo = mid + 1;
+        else       hi = mid - 1;
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    uint8_t     value;
+    uint8_t     flags;          // MEM_OBJ_SYM_*
+} mem_obj_symdef_t;
+
+typedef struct {
+    uint8_t  addr;              // byte to patch
+    uint16_t sym;               // index into the symbol array
+} mem_obj_relocdef_t;
+
+typedef struct {
+    const uint8_t *mem;         // 256-byte image
+    const uint8_t *used;        // 1 = byte was emitted
+    const uint8_t *code;        // 1 = byte of an instruction (NULL: all data)
+    uint8_t        entry;
+    uint8_t        flags;       // MEM_OBJ_RELOCATABLE
+    const mem_obj_symdef_t   *syms;     // sorted by name (strcmp)
+    int                       nsyms;
+    const mem_obj_relocdef_t *relocs;
+    int                       nrelocs;
+} mem_obj_out_t;
+
+// One segment per run of used bytes, split where code turns into data or
+// back. Returns the number of segments.
+static inline int mem_obj_segments(const mem_obj_out_t *out, uint8_t seg_addr[],
+                                   int seg_len[], uint8_t seg_flags[]) {
+    int n = 0;
+    for (int a = 0; a < MEM_OBJ_MEM_SIZE; a++) {
+        if (!out->used[a]) continue;
+        uint8_t f = out->code && out->code[a] ? MEM_OBJ_SEG_CODE : 0;
+        if (n > 0 && seg_addr[n - 1] + seg_len[n - 1] == a && seg_flags[n - 1] == f) {
+            seg_len[n - 1]++;
+            continue;
+        }
+        seg_addr[n] = (uint8_t)a;
+        seg_len[n] = 1;
+        seg_flags[n] = f;
+        n++;
+    }
+    return n;
+}
+
+// Write out to path. Returns 0, or -1 with errno set (EOVERFLOW if the
+// tables do not fit the format).
+static inline int mem_obj_write(const char *path, const mem_obj_out_t *out) {
+    uint8_t seg_addr[MEM_OBJ_MEM_SIZE], seg_flags[MEM_OBJ_MEM_SIZE];
+    int seg_len[MEM_OBJ_MEM_SIZE];
+    int nsegs = mem_obj_segments(out, seg_addr, seg_len, seg_flags);
+
+    size_t strtab_len = 0;
+    for (int i = 0; i < out->nsyms; i++) strtab_len += strlen(out->syms[i].name) + 1;
+    if (nsegs > 255 || out->nsyms > 0xFFFF || strtab_len > 0xFFFF || out->nrelocs > 0xFFFF) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+
+    size_t strtab = MEM_OBJ_HEADER_SIZE + (size_t)nsegs * MEM_OBJ_SEG_SIZE
+                  + (size_t)out->nsyms * MEM_OBJ_SYM_SIZE
+                  + (size_t)out->nrelocs * MEM_OBJ_RELOC_SIZE;
+    size_t total = strtab + strtab_len;
+    for (int i = 0; i < nsegs; i++) total += (size_t)seg_len[i];
+
+    uint8_t *buf = (uint8_t *)calloc(1, total);
+    if (!buf) return -1;
+
+    memcpy(buf, MEM_OBJ_MAGIC, 4);
+    buf[4] = MEM_OBJ_VERSION;
+    buf[5] = out->entry;
+    buf[6] = (uint8_t)nsegs;
+    buf[7] = out->flags;
+    mem_obj_wr16(buf + 8, (uint16_t)out->nsyms);
+    mem_obj_wr16(buf + 10, (uint16_t)strtab_len);
+    mem_obj_wr16(buf + 12, (uint16_t)out->nrelocs);
+
+    uint8_t *p = buf + MEM_OBJ_HEADER_SIZE;
+    size_t at = strtab + strtab_len;
+    for (int i = 0; i < nsegs; i++, p += MEM_OBJ_SEG_SIZE) {
+        p[0] = seg_addr[i];
+        p[1] = seg_flags[i];
+        mem_obj_wr16(p + 2, (uint16_t)seg_len[i]);
+        mem_obj_wr32(p + 4, (uint32_t)at);
+        memcpy(buf + at, out->mem + seg_addr[i], (size_t)seg_len[i]);
+        at += (size_t)seg_len[i];
+    }
+
+    size_t name = 0;
+    for (int i = 0; i < out->nsyms; i++, p += MEM_OBJ_SYM_SIZE) {
+        const mem_obj_symdef_t *s = &out->syms[i];
+        uint8_t seg = MEM_OBJ_NO_SEG;
+        if (!(s->flags & (MEM_OBJ_SYM_ABS | MEM_OBJ_SYM_EXTERN))) {
+            // the segment holding the value, else the one ending there
+            for (int k = 0; k < nsegs && seg == MEM_OBJ_NO_SEG; k++)
+                if (s->value >= seg_addr[k] && s->value < seg_addr[k] + seg_len[k]) seg = (uint8_t)k;
+            for (int k = 0; k < nsegs && seg == MEM_OBJ_NO_SEG; k++)
+                if (s->value == seg_addr[k] + seg_len[k]) seg = (uint8_t)k;
+        }
+        mem_obj_wr16(p, (uint16_t)name);
+        p[2] = s->value;
+        p[3] = s->flags;
+        p[4] = seg;
+        size_t n = strlen(s->name) + 1;
+        memcpy(buf + strtab + name, s->name, n);
+        name += n;
+    }
+
+    for (int i = 0; i < out->nrelocs; i++, p += MEM_OBJ_RELOC_SIZE) {
+        p[0] = out->relocs[i].addr;
+        mem_obj_wr16(p + 2, out->relocs[i].sym);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        free(buf);
+        return -1;
+    }
+    int ok = fwrite(buf, 1, total, f) == total;
+    if (fclose(f) != 0) ok = 0;
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+#endif // MEM_OBJ_H
@@ -2,8 +2,92 @@
 ../Export_week2/assembler_v2.x  factorialIN.asm factorial
 
 ../Export_week2/assembler_v2.x  sumaIN.asm suma
+# (also writes factorial.obj / suma.obj, the binary objects the driver maps;
+#  -DFACT_IMAGE='"factorial.mem"' -DSUMA_IMAGE='"suma.mem"' goes back to text)
+
+# Both modules export their entry point and arguments (.global), so the
+# linker can pack them into one image for --linked batch mode
+../Export_week2/linker.x -o main2link.obj factorial.obj suma.obj
 
 gcc -std=c11 -Wall -Wextra -O2 -c cpu_core.c -o cpu_core.o
-gcc -std=c11 -Wall -Wextra -O2 -Wno-unused-result main2link_loadmem.c cpu_core.o -o main2link_loadmem.x
+gcc -std=c11 -Wall -Wextra -O2 -c job_pool.c -o job_pool.o
+gcc -std=c11 -Wall -Wextra -O2 -c mem_image.c -o mem_image.o
+gcc -std=c11 -Wall -Wextra -O2 -c cpu_jit.c -o cpu_jit.o
+gcc -std=c11 -Wall -Wextra -O2 -c mem_table.c -o mem_table.o
+gcc -std=c11 -Wall -Wextra -O2 -Wno-unused-result main2link_loadmem.c cpu_core.o cpu_jit.o job_pool.o mem_image.o mem_table.o -pthread -o main2link_loadmem.x
 ./main2link_loadmem.x
 
+# Batch mode: one "N1 N2" pair per line, -j = number of worker threads
+# ./main2link_loadmem.x --batch pairs.txt -j 8 > results.txt
+# (--jit: run the images as x86-64 code translated by cpu_jit.c)
+# (--linked: load main2link.obj once per worker and call both routines
+#  in place, no image reload between calls; works with --jit)
+
+# 32-bit results: factorial32 / suma32 carry every byte with ADD/ADC/JC
+# (exact up to 12! = 479001600); --wide runs them instead, on the
+# interpreter or --jit
+../Export_week2/assembler_v2.x  factorial32IN.asm factorial32
+../Export_week2/assembler_v2.x  suma32IN.asm suma32
+# ./main2link_loadmem.x --batch pairs.txt --wide > results.txt
+
+# Exhaustive tables of the pure routines: all 256 N / all 65536 (A, B)
+# pairs, then batch mode answers by lookup (--table)
+gcc -std=c11 -Wall -Wextra -O2 tabulate.c mem_table.o job_pool.o cpu_core.o mem_image.o -pthread -o tabulate.x
+./tabulate.x factorial.mem factorial.tab 0xC0 0xC1
+./tabulate.x suma.mem suma.tab 0x20 0x21 0x22
+# ./main2link_loadmem.x --batch pairs.txt --table > results.txt
+
+# Lane-parallel interpreter: sweep N = 0..255 through factorial.mem and
+# compare against cpu_run() (-march=native picks AVX2 / AVX-512 lanes)
+gcc -std=c11 -Wall -Wextra -O2 -march=native simd_sweep.c cpu_simd.c cpu_core.o mem_image.o -o simd_sweep.x
+./simd_sweep.x factorial.mem 0xC0 0xC1
+
+# Dispatch engines: switch vs. computed goto vs. JIT (instructions/sec),
+# plus the interpreter variants with bounds / breakpoint / profile checks
+# compiled in (cpu_engine() picks one of the 16 combinations at runtime)
+# (-DCPU_NO_THREADED on cpu_core.c builds only the switch engine,
+#  -DCPU_NO_FUSION turns off the predecoded engine's superinstructions)
+gcc -std=c11 -Wall -Wextra -O2 bench_dispatch.c cpu_core.o cpu_jit.o mem_image.o -o bench_dispatch.x
+./bench_dispatch.x
+
+# Generate -> assemble -> run in one process (asm_assemble() from
+# ../Export_week2/asm_lib.c, no .asm/.mem files): every suma (A, B) and
+# factorial N variant, checked against C
+gcc -std=c11 -Wall -Wextra -O2 asm_sweep.c ../Export_week2/asm_lib.c cpu_core.o -o asm_sweep.x
+./asm_sweep.x
+# (-O: also assemble each variant with the optimizer and compare the
+#  instructions executed / run time of both images)
+# ./asm_sweep.x -O
+
+# Differential check on random programs: cpu_run, the 16 cpu_engine()
+# variants, the predecoded engine and the JIT against a reference model
+# of isa.h (memory, ACC, C, X, PC, steps), then every source assembled
+# with and without -O (modules with .global called twice, as --linked)
+gcc -std=c11 -Wall -Wextra -O2 fuzz_engines.c ../Export_week2/asm_lib.c cpu_core.o cpu_jit.o -o fuzz_engines.x
+./fuzz_engines.x 100000 1
+
+# Benchmark suite -> JSON (assembler lines/s on synthetic sources of 1k..1M
+# lines; factorial, suma, sweepIN.asm, sweepxIN.asm and mulIN.asm on every
+# engine: instr/s, ns/run, image and context bytes). Keep one file per
+# version and compare them to catch regressions (-q: quick, -t: seconds per
+# case)
+gcc -std=c11 -Wall -Wextra -O2 bench_suite.c ../Export_week2/asm_lib.c cpu_core.o cpu_jit.o -o bench_suite.x
+./bench_suite.x -l "$(git rev-parse --short HEAD)" > bench.json
+
+# Profile: run an image on cpu_run_profile() (a separately compiled
+# interpreter that counts every PC, opcode and JZ/JNZ/JC outcome) and print
+# its .lst with the hits and share of each line
+gcc -std=c11 -Wall -Wextra -O2 -c cpu_profile.c -o cpu_profile.o
+gcc -std=c11 -Wall -Wextra -O2 profile.c cpu_profile.o cpu_core.o mem_image.o -o profile.x
+./profile.x factorial.mem factorial.lst 0xC0=5
+# ./profile.x suma.mem suma.lst 0x20=120 0x21=6 -n 100
+# (--bounds: stop if execution runs past 0xFF; --trace: print every
+#  instruction with ACC, C and X)
+
+# Ahead-of-time translation: factorial.mem / suma.mem -> native C functions
+# linked into the driver (--aot in batch mode)
+gcc -std=c11 -Wall -Wextra -O2 mem2c.c mem_image.o -o mem2c.x
+./mem2c.x factorial.mem factorial
+./mem2c.x suma.mem suma
+gcc -std=c11 -Wall -Wextra -O2 -Wno-unused-result -DMAIN2LINK_AOT main2link_loadmem.c factorial_aot.c suma_aot.c cpu_core.o cpu_jit.o job_pool.o mem_image.o mem_table.o -pthread -o main2link_aot.x
+./main2link_aot.x
@@ -0,0 +1,291 @@
+// asm_sweep.c
+// Generate -> assemble -> run, all in one process: the flow of
+// c_to_asm.c + assembler_v2.x + main2link without files or processes in
+// between (the assembler is ../Export_week2/asm_lib.c).
+//
+// Usage: ./asm_sweep.x [-O] [repeats]      (default 1)
+//
+// Like generarASM() in c_to_asm.c, every variant is a program with its
+// arguments baked in as .byte data: suma for all 65536 (A, B) pairs and
+// factorial for N = 0..255. Each one is printed into a buffer, assembled
+// with asm_assemble(), loaded with cpu_load() and run; the result is
+// checked against C. Prints programs/sec and the assemble / run split.
+//
+// -O also assembles every variant with the optimizer (asm_result.optimize)
+// and runs both images: same results, plus the static instruction counts
+// and the dynamic speedup (instructions executed, run time) on cpu_run(),
+// for suma and factorial separately.
+// It first checks three modules whose STOREs -O must keep: a private
+// counter that only the next call reads, a slot read after a jump to an
+// .extern returns through a .global label (both as --linked runs them),
+// and a slot exported only through a .global .equ alias.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_core.h"
+#include "../Export_week2/asm_lib.h"
+
+static const char suma_src[] =
+    "; suma.asm - suma A + B -> RES\n"
+    "    .org 0x00\n"
+    "    LOAD  A\n"
+    "    ADD   B\n"
+    "    STORE RES\n"
+    "    HALT\n"
+    "    .org 0x20\n"
+    "A:      .byte %d\n"
+    "B:      .byte %d\n"
+    "RES:    .byte 0\n";
+
+static const char factorial_src[] =
+    "; factorial.asm - N! con sumas repetidas\n"
+    "    .org 0x00\n"
+    "    LOAD  ONE\n"
+    "    STORE RESULT\n"
+    "    LOAD  N\n"
+    "    STORE COUNTER\n"
+    "LOOP:\n"
+    "    LOAD  COUNTER\n"
+    "    JZ    END\n"
+    "    LOAD  ZERO\n"
+    "    STORE PART\n"
+    "    LOAD  COUNTER\n"
+    "    STORE TEMP\n"
+    "INNER:\n"
+    "    LOAD  PART\n"
+    "    ADD   RESULT\n"
+    "    STORE PART\n"
+    "    LOAD  TEMP\n"
+    "    ADD   NEG1\n"
+    "    STORE TEMP\n"
+    "    LOAD  TEMP\n"
+    "    JZ    INNER_END\n"
+    "    JMP   INNER\n"
+    "INNER_END:\n"
+    "    LOAD  PART\n"
+    "    STORE RESULT\n"
+    "    LOAD  COUNTER\n"
+    "    ADD   NEG1\n"
+    "    STORE COUNTER\n"
+    "    JMP   LOOP\n"
+    "END:\n"
+    "    LOAD  RESULT\n"
+    "    HALT\n"
+    "    .org 0xC0\n"
+    "N:      .byte %d\n"
+    "RESULT: .byte 0\n"
+    "COUNTER:.byte 0\n"
+    "TEMP:   .byte 0\n"
+    "PART:   .byte 0\n"
+    "ONE:    .byte 1\n"
+    "ZERO:   .byte 0\n"
+    "NEG1:   .byte 255\n";
+
+// Called twice with memory kept: the second call must see CNT = 1
+static const char counter_src[] =
+    "; contador privado entre llamadas\n"
+    "        .global ENTRY, RES\n"
+    "        .org 0x00\n"
+    "ENTRY:  LOAD  CNT\n"
+    "        ADDI  1\n"
+    "        STORE CNT\n"
+    "        STORE RES\n"
+    "        HALT\n"
+    "        .org 0x40\n"
+    "CNT:    .byte 0\n"
+    "RES:    .byte 0\n";
+
+// F comes back to BACK, which reads T
+static const char extern_src[] =
+    "; T se lee a la vuelta de F\n"
+    "        .global ENTRY, BACK, RES\n"
+    "        .extern F\n"
+    "        .org 0x00\n"
+    "ENTRY:  LOAD  A\n"
+    "        ADDI  1\n"
+    "        STORE T\n"
+    "        JMP   F\n"
+    "BACK:   LOAD  T\n"
+    "        STORE RES\n"
+    "        HALT\n"
+    "        .org 0x40\n"
+    "A:      .byte 5\n"
+    "T:      .byte 0\n"
+    "RES:    .byte 0\n";
+
+// RES is R under another name: R is not private
+static const char equ_src[] =
+    "; slot exportado con un alias .equ\n"
+    "        .global ENTRY, RES\n"
+    "        .equ RES 0x41\n"
+    "        .org 0x00\n"
+    "ENTRY:  LOAD  IN\n"
+    "        ADD   IN\n"
+    "        STORE R\n"
+    "        HALT\n"
+    "        .org 0x40\n"
+    "IN:     .byte 3\n"
+    "R:      .byte 0\n";
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double   t_asm, t_run;
+    uint64_t steps;         // instructions executed
+    long     insns;         // static instructions (last variant)
+} sweep_stats_t;
+
+enum { SUMA, FACTORIAL, NPROGS };
+static const char *const prog_name[NPROGS] = { "suma", "factorial" };
+static sweep_stats_t plain[NPROGS], optimized[NPROGS];
+
+// Assembles src, runs it and returns the byte at out_addr (-1 on error)
+static int assemble_and_run(cpu_t *c, asm_result *r, const char *src, int len,
+                            uint8_t out_addr, int prog, int optimize) {
+    sweep_stats_t *st = optimize ? &optimized[prog] : &plain[prog];
+    r->optimize = optimize;
+    double t0 = now_sec();
+    if (asm_assemble(src, (size_t)len, r) != 0) {
+        fprintf(stderr, "ERROR: %s\n", r->error);
+        return -1;
+    }
+    double t1 = now_sec();
+    cpu_load(c, r->mem);
+    cpu_reset(c);
+    int rc = cpu_run(c);
+    double t2 = now_sec();
+    if (optimize) {
+        if (r->opt.skipped[0]) fprintf(stderr, "-O: %s\n", r->opt.skipped);
+        plain[prog].insns = r->opt.insns_before;
+        optimized[prog].insns = r->opt.insns_after;
+    }
+    asm_result_free(r);
+
+    st->t_asm += t1 - t0;
+    st->t_run += t2 - t1;
+    st->steps += c->steps;
+    return rc == 0 ? c->mem[out_addr] : -1;
+}
+
+static int symbol(const asm_result *r, const char *name) {
+    for (int i = 0; i < r->nsyms; i++)
+        if (strcmp(r->syms[i].name, name) == 0) return r->syms[i].value;
+    return -1;
+}
+
+// Assembles src with -O, resolves every .extern to the label back, runs
+// it calls times keeping memory and returns RES (-1 on error)
+static int run_module(cpu_t *c, asm_result *r, const char *src, const char *back, int calls) {
+    r->optimize = 1;
+    if (asm_assemble(src, strlen(src), r) != 0) {
+        fprintf(stderr, "ERROR: %s\n", r->error);
+        return -1;
+    }
+    cpu_load(c, r->mem);
+    for (int i = 0; i < r->nrelocs; i++) {
+        if (r->syms[r->relocs[i].sym].flags & MEM_OBJ_SYM_EXTERN)
+            cpu_write(c, r->relocs[i].addr, (uint8_t)symbol(r, back));
+    }
+    int res = symbol(r, "RES");
+    for (int k = 0; k < calls; k++) {
+        cpu_reset(c);
+        if (cpu_run(c) != 0) res = -1;
+    }
+    if (res >= 0) res = c->mem[res];
+    asm_result_free(r);
+    return res;
+}
+
+int main(int argc, char **argv) {
+    int opt = argc > 1 && strcmp(argv[1], "-O") == 0;
+    int repeats = argc > 1 + opt ? atoi(argv[1 + opt]) : 1;
+    if (repeats < 1) repeats = 1;
+
+    static cpu_t cpu;
+    static asm_result r;
+    char src[2048];
+    long programs = 0;
+
+    cpu_init(&cpu);
+    if (opt) {
+        int res = run_module(&cpu, &r, counter_src, "ENTRY", 2);
+        if (res != 2) {
+            fprintf(stderr, "-O: private counter after 2 calls = %d, expected 2\n", res);
+            return 1;
+        }
+        res = run_module(&cpu, &r, extern_src, "BACK", 1);
+        if (res != 6) {
+            fprintf(stderr, "-O: slot read after a jump to an .extern = %d, expected 6\n", res);
+            return 1;
+        }
+        res = run_module(&cpu, &r, equ_src, "ENTRY", 1);
+        if (res != 6) {
+            fprintf(stderr, "-O: slot exported through an .equ = %d, expected 6\n", res);
+            return 1;
+        }
+    }
+    double t0 = now_sec();
+    for (int rep = 0; rep < repeats; rep++) {
+        for (int a = 0; a < 256; a++) {
+            for (int b = 0; b < 256; b++) {
+                int len = snprintf(src, sizeof src, suma_src, a, b);
+                for (int o = 0; o <= opt; o++) {
+                    int res = assemble_and_run(&cpu, &r, src, len, 0x22, SUMA, o);
+                    if (res != ((a + b) & 0xFF)) {
+                        fprintf(stderr, "suma(%d, %d) = %d, expected %d%s\n", a, b, res,
+                                (a + b) & 0xFF, o ? " (-O)" : "");
+                        return 1;
+                    }
+                }
+                programs++;
+            }
+        }
+        uint8_t fact = 1;
+        for (int n = 0; n < 256; n++) {
+            if (n > 0) fact = (uint8_t)(fact * n);
+            int len = snprintf(src, sizeof src, factorial_src, n);
+            for (int o = 0; o <= opt; o++) {
+                int res = assemble_and_run(&cpu, &r, src, len, 0xC1, FACTORIAL, o);
+                if (res != fact) {
+                    fprintf(stderr, "factorial(%d) = %d, expected %d%s\n", n, res, fact,
+                            o ? " (-O)" : "");
+                    return 1;
+                }
+            }
+            programs++;
+        }
+    }
+    double dt = now_sec() - t0;
+
+    printf("%ld programs generated, assembled and run in %.3f s (%.0f programs/sec)\n",
+           programs, dt, (double)programs / dt);
+    double t_asm = plain[SUMA].t_asm + plain[FACTORIAL].t_asm;
+    printf("  assemble %.3f s (%.2f us/program), run %.3f s\n",
+           t_asm, t_asm * 1e6 / (double)programs, plain[SUMA].t_run + plain[FACTORIAL].t_run);
+    if (opt) {
+        t_asm = optimized[SUMA].t_asm + optimized[FACTORIAL].t_asm;
+        printf("-O: assemble %.3f s (%.2f us/program), run %.3f s\n",
+               t_asm, t_asm * 1e6 / (double)programs,
+               optimized[SUMA].t_run + optimized[FACTORIAL].t_run);
+        // Each program on its own: suma's 65536 short runs would swamp factorial
+        for (int p = 0; p < NPROGS; p++) {
+            const sweep_stats_t *a = &plain[p], *b = &optimized[p];
+            printf("-O: %s %ld -> %ld instructions; %llu -> %llu executed "
+                   "(%.2fx fewer), run time %.2fx faster\n",
+                   prog_name[p], a->insns, b->insns,
+                   (unsigned long long)a->steps, (unsigned long long)b->steps,
+                   (double)a->steps / (double)b->steps, a->t_run / b->t_run);
+        }
+    }
+    return 0;
+}
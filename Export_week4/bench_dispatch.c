@@ -0,0 +1,125 @@
+// bench_dispatch.c
+// Compares the dispatch engines of cpu_core.c (switch, computed goto,
+// computed goto over the predecoded instruction cache) and the x86-64
+// JIT of cpu_jit.c on the assembled factorial and suma images.
+//
+// Usage: ./bench_dispatch.x [seconds_per_case]      (default 0.5)
+//
+// For every image and engine the guest program is reloaded and run in a
+// loop for the given time; the table shows guest instructions/sec and
+// nanoseconds per complete run. Engines that execute superinstructions
+// (predecoded) are followed by their hits per run for each pattern.
+// The +bounds / +break / +profile rows are the interpreter variants with
+// those checks compiled in (cpu_engine), to show what each one costs.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_core.h"
+#include "cpu_jit.h"
+#include "mem_image.h"
+
+typedef struct {
+    const char *name;
+    int (*run)(cpu_t *);
+} engine_t;
+
+typedef struct {
+    const char *label;
+    const char *file;
+    uint8_t in_addr[2];
+    uint8_t in_val[2];
+    int nin;
+} workload_t;
+
+static cpu_jit_t *jit;
+
+static int run_jit(cpu_t *c) {
+    return cpu_jit_run(jit, c);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    double budget = argc > 1 ? atof(argv[1]) : 0.5;
+
+    jit = cpu_jit_new();
+
+    const engine_t engines[] = {
+        { "switch",   cpu_run_switch },
+#if CPU_HAVE_THREADED
+        { "threaded", cpu_run_threaded },
+        { "predecoded", cpu_run_predecoded },
+#endif
+        { jit ? "jit" : "jit(n/a)", run_jit },
+        { "+bounds",  cpu_engine(CPU_POLICY_BOUNDS) },
+        { "+break",   cpu_engine(CPU_POLICY_BREAK) },
+        { "+profile", cpu_engine(CPU_POLICY_PROFILE) },
+        { "+all",     cpu_engine(CPU_POLICY_BOUNDS | CPU_POLICY_BREAK | CPU_POLICY_PROFILE) },
+    };
+    const workload_t workloads[] = {
+        { "factorial(5)", "factorial.mem", { 0xC0 },       { 5 },       1 },
+        { "factorial(9)", "factorial.mem", { 0xC0 },       { 9 },       1 },
+        { "suma(120,6)",  "suma.mem",      { 0x20, 0x21 }, { 120, 6 },  2 },
+    };
+    const int nengines = (int)(sizeof engines / sizeof engines[0]);
+    const int nworkloads = (int)(sizeof workloads / sizeof workloads[0]);
+
+    static cpu_t c;
+    static cpu_profile_t prof;
+    static const uint8_t no_breakpoints[MEM_SIZE];
+    cpu_init(&c);
+    c.profile = &prof;
+    c.breakpoints = no_breakpoints;
+
+    printf("%-14s %-10s %14s %12s %10s\n",
+           "workload", "engine", "instr/s", "ns/run", "instr/run");
+    for (int w = 0; w < nworkloads; w++) {
+        const workload_t *wl = &workloads[w];
+        uint8_t img[MEM_SIZE];
+        if (mem_image_read(wl->file, img) < 0) return 1;
+        cpu_jit_flush(jit);     // time translation as part of the first runs
+
+        for (int e = 0; e < nengines; e++) {
+            uint64_t runs = 0, instr = 0;
+            uint64_t fused0[CPU_FUSED_COUNT];
+            memcpy(fused0, c.fused, sizeof fused0);
+            double t0 = now_sec(), dt;
+            do {
+                for (int k = 0; k < 1000; k++) {
+                    cpu_load(&c, img);
+                    for (int i = 0; i < wl->nin; i++)
+                        cpu_write(&c, wl->in_addr[i], wl->in_val[i]);
+                    cpu_reset(&c);
+                    engines[e].run(&c);
+                    instr += c.steps;
+                }
+                runs += 1000;
+                dt = now_sec() - t0;
+            } while (dt < budget);
+
+            printf("%-14s %-10s %14.0f %12.1f %10llu\n",
+                   wl->label, engines[e].name, (double)instr / dt,
+                   dt * 1e9 / (double)runs,
+                   (unsigned long long)(instr / runs));
+
+            for (int k = 0; k < CPU_FUSED_COUNT; k++) {
+                uint64_t hits = c.fused[k] - fused0[k];
+                if (hits)
+                    printf("%-14s   %-24s %10.1f /run\n", "", cpu_fused_names[k],
+                           (double)hits / (double)runs);
+            }
+        }
+    }
+    cpu_jit_free(jit);
+    return 0;
+}
@@ -0,0 +1,332 @@
+// bench_suite.c
+// Benchmark suite: assembler throughput and guest workloads on every
+// execution engine, as JSON for tracking regressions between versions.
+//
+// Usage: ./bench_suite.x [-t seconds_per_case] [-l label] [-q] > bench.json
+//        -t  time budget per measurement (default 0.3)
+//        -l  free-form label stored in the JSON (e.g. a git revision)
+//        -q  quick: stop the assembler sizes at 100k lines
+//
+// Assembler: synthetic sources of 1k .. 1M lines (blocks of labels, a long
+// forward jump chain, .byte tables and .equ constants, each block under
+// its own .org 0 so any size fits in memory) go through asm_assemble(),
+// the assembler of assembler_v2 (../Export_week2/asm_lib.c). Reports
+// lines/sec, MB/sec and the peak RSS of the process after each size.
+//
+// Engines: the corpus below is assembled from its .asm sources and run
+// on cpu_run_switch / threaded / predecoded and the JIT, reloading the
+// image before every run as bench_dispatch does. Every run's result is
+// checked against C. Reports instructions/sec, ns per run, instructions
+// per run and memory: the bytes of the image and of the cpu_t context.
+//
+// Progress goes to stderr, the JSON to stdout. On a failure (a source that
+// does not assemble, a wrong result) the run stops, the open array is
+// closed and the JSON gets an "error" field; the exit status is 1.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "cpu_core.h"
+#include "cpu_jit.h"
+#include "../Export_week2/asm_lib.h"
+
+#define SCHEMA_VERSION 1
+
+typedef struct {
+    const char *name;
+    int (*run)(cpu_t *);
+} engine_t;
+
+typedef struct {
+    const char *label;
+    const char *file;       // source, assembled at startup
+    uint8_t in_addr[2];
+    uint8_t in_val[2];
+    int nin;
+    uint8_t out_addr;
+    int expected;
+} workload_t;
+
+static cpu_jit_t *jit;
+static char error[256];     // first failure, also reported in the JSON
+
+// Reports a failure on stderr and keeps it for the "error" field
+static void fail(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(error, sizeof error, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "bench_suite: %s\n", error);
+}
+
+// Prints s as the body of a JSON string
+static void json_string(const char *s) {
+    for (const char *p = s; *p; p++) {
+        if (*p == '"' || *p == '\\') putchar('\\');
+        if ((unsigned char)*p >= 0x20) putchar(*p);
+    }
+}
+
+static int run_jit(cpu_t *c) {
+    return cpu_jit_run(jit, c);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long maxrss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;    // KB on Linux
+}
+
+// ---------------------------------------------------------------------
+// Assembler half
+// ---------------------------------------------------------------------
+#define CHAIN 24    // JMPs per block
+
+typedef struct {
+    char  *buf;
+    size_t len, cap;
+} text_t;
+
+static void text_add(text_t *t, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(t->buf + t->len, t->cap - t->len, fmt, ap);
+        va_end(ap);
+        if (t->len + (size_t)n < t->cap) {
+            t->len += (size_t)n;
+            return;
+        }
+        t->cap = t->cap ? t->cap * 2 : 1 << 16;
+        t->buf = realloc(t->buf, t->cap);
+        if (!t->buf) {
+            perror("bench_suite");
+            exit(1);
+        }
+    }
+}
+
+// Synthetic source of at least `lines` lines; returns the exact count
+static long gen_source(text_t *t, long lines) {
+    long n = 0;
+    t->len = 0;
+    for (long b = 0; n < lines; b++) {
+        text_add(t, "; block %ld\n        .org 0x00\n", b);
+        n += 2;
+        for (int i = 0; i < CHAIN; i++, n++)
+            text_add(t, "B%ld_J%d: JMP B%ld_J%d\n", b, i, b, i + 1);
+        text_add(t, "B%ld_J%d: LOAD B%ld_T\n"
+                    "        ADD   B%ld_K\n"
+                    "        STORE B%ld_V\n"
+                    "        JZ    B%ld_J0\n"
+                    "        HALT\n", b, CHAIN, b, b, b, b);
+        n += 5;
+        text_add(t, "        .org 0x80\n");
+        n++;
+        for (int row = 0; row < 4; row++, n++) {
+            text_add(t, row == 0 ? "B%ld_T:  .byte" : "        .byte", b);
+            for (int k = 0; k < 16; k++)
+                text_add(t, "%s %d", k ? "," : "", (int)((b + row * 16 + k) & 0xFF));
+            text_add(t, "\n");
+        }
+        text_add(t, "B%ld_V:  .byte 0\n        .equ B%ld_K 0x%02lX\n", b, b, b & 0xFF);
+        n += 2;
+    }
+    return n;
+}
+
+static int bench_assembler(double budget, int quick) {
+    static const long sizes[] = { 1000, 10000, 100000, 1000000 };
+    text_t src = { 0 };
+    int first = 1, rc = 0;
+
+    printf("  \"assembler\": [\n");
+    for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; s++) {
+        if (quick && sizes[s] > 100000) break;
+        long lines = gen_source(&src, sizes[s]);
+
+        static asm_result r;
+        long runs = 0;
+        double t0 = now_sec(), dt;
+        do {
+            if (asm_assemble(src.buf, src.len, &r) != 0) {
+                fail("generated source: %s", r.error);
+                rc = -1;
+                goto out;
+            }
+            asm_result_free(&r);
+            runs++;
+            dt = now_sec() - t0;
+        } while (dt < budget);
+
+        double per_run = dt / (double)runs;
+        fprintf(stderr, "assembler %8ld lines  %12.0f lines/s\n", lines, (double)lines / per_run);
+        printf("%s    { \"lines\": %ld, \"bytes\": %zu, \"runs\": %ld, \"s_per_run\": %.6f, "
+               "\"lines_per_s\": %.0f, \"mb_per_s\": %.2f, \"maxrss_kb\": %ld }",
+               first ? "" : ",\n", lines, src.len, runs, per_run,
+               (double)lines / per_run, (double)src.len / per_run / 1e6, maxrss_kb());
+        first = 0;
+    }
+out:
+    printf("\n  ],\n");    // closed on failure too: the JSON stays valid
+    free(src.buf);
+    return rc;
+}
+
+// ---------------------------------------------------------------------
+// Engine half
+// ---------------------------------------------------------------------
+static int assemble_file(const char *path, uint8_t img[MEM_SIZE], int *used) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fail("%s: %s", path, strerror(errno));
+        return -1;
+    }
+    text_t t = { 0 };
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof chunk, f)) > 0)
+        text_add(&t, "%.*s", (int)n, chunk);
+    fclose(f);
+
+    static asm_result r;
+    int rc = asm_assemble(t.buf ? t.buf : "", t.len, &r);
+    free(t.buf);
+    if (rc != 0) {
+        fail("%s: %s", path, r.error);
+        return -1;
+    }
+    memcpy(img, r.mem, MEM_SIZE);
+    *used = 0;
+    for (int a = 0; a < MEM_SIZE; a++) *used += r.used[a];
+    asm_result_free(&r);
+    return 0;
+}
+
+static int bench_engines(double budget) {
+    const engine_t engines[] = {
+        { "switch",   cpu_run_switch },
+#if CPU_HAVE_THREADED
+        { "threaded", cpu_run_threaded },
+        { "predecoded", cpu_run_predecoded },
+#endif
+        { jit ? "jit" : "jit(n/a)", run_jit },
+    };
+    // expected: factorial / product mod 256, sum of TABLE = 1..64
+    const workload_t workloads[] = {
+        { "factorial(5)", "factorialIN.asm", { 0xC0 },       { 5 },       1, 0xC1, 120 },
+        { "factorial(9)", "factorialIN.asm", { 0xC0 },       { 9 },       1, 0xC1, 0x80 },
+        { "suma(120,6)",  "sumaIN.asm",      { 0x20, 0x21 }, { 120, 6 },  2, 0x22, 126 },
+        { "sweep(64)",    "sweepIN.asm",     { 0xB1 },       { 64 },      1, 0xB0, (64 * 65 / 2) & 0xFF },
+        { "sweepx(64)",   "sweepxIN.asm",    { 0xB1 },       { 64 },      1, 0xB0, (64 * 65 / 2) & 0xFF },
+        { "mul(13,17)",   "mulIN.asm",       { 0x40, 0x41 }, { 13, 17 },  2, 0x42, (13 * 17) & 0xFF },
+    };
+    const int nengines = (int)(sizeof engines / sizeof engines[0]);
+    const int nworkloads = (int)(sizeof workloads / sizeof workloads[0]);
+
+    static cpu_t c;
+    cpu_init(&c);
+    int first = 1, rc = 0;
+
+    printf("  \"engines\": [\n");
+    for (int w = 0; w < nworkloads; w++) {
+        const workload_t *wl = &workloads[w];
+        uint8_t img[MEM_SIZE];
+        int used;
+        if (assemble_file(wl->file, img, &used) != 0) {
+            rc = -1;
+            goto out;
+        }
+        cpu_jit_flush(jit);     // time translation as part of the first runs
+
+        for (int e = 0; e < nengines; e++) {
+            uint64_t runs = 0, instr = 0;
+            int ok = 1;
+            double t0 = now_sec(), dt;
+            do {
+                for (int k = 0; k < 1000; k++) {
+                    cpu_load(&c, img);
+                    for (int i = 0; i < wl->nin; i++)
+                        cpu_write(&c, wl->in_addr[i], wl->in_val[i]);
+                    cpu_reset(&c);
+                    if (engines[e].run(&c) != 0 || c.mem[wl->out_addr] != wl->expected) ok = 0;
+                    instr += c.steps;
+                }
+                runs += 1000;
+                dt = now_sec() - t0;
+            } while (dt < budget);
+
+            fprintf(stderr, "%-14s %-10s %14.0f instr/s %10.1f ns/run%s\n", wl->label,
+                    engines[e].name, (double)instr / dt, dt * 1e9 / (double)runs,
+                    ok ? "" : "  WRONG RESULT");
+            printf("%s    { \"workload\": \"%s\", \"engine\": \"%s\", \"ok\": %s, "
+                   "\"instr_per_run\": %llu, \"ns_per_run\": %.1f, \"instr_per_s\": %.0f, "
+                   "\"image_bytes\": %d, \"ctx_bytes\": %zu }",
+                   first ? "" : ",\n", wl->label, engines[e].name, ok ? "true" : "false",
+                   (unsigned long long)(instr / runs), dt * 1e9 / (double)runs,
+                   (double)instr / dt, used, sizeof(cpu_t));
+            first = 0;
+            if (!ok) {
+                fail("%s on %s: wrong result", wl->label, engines[e].name);
+                rc = -1;
+                goto out;
+            }
+        }
+    }
+out:
+    printf("\n  ],\n");
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    double budget = 0.3;
+    const char *label = "";
+    int quick = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            budget = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quick = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [-t seconds_per_case] [-l label] [-q]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    jit = cpu_jit_new();
+
+    time_t now = time(NULL);
+    char tbuf[32];
+    strftime(tbuf, sizeof tbuf, "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    printf("{\n  \"schema\": %d,\n  \"label\": \"", SCHEMA_VERSION);
+    json_string(label);
+    printf("\",\n  \"date\": \"%s\",\n  \"budget_s\": %.3f,\n", tbuf, budget);
+
+    int rc = bench_assembler(budget, quick) == 0 && bench_engines(budget) == 0 ? 0 : 1;
+    if (rc != 0) {
+        printf("  \"error\": \"");
+        json_string(error);
+        printf("\",\n");
+    }
+    printf("  \"maxrss_kb\": %ld\n}\n", maxrss_kb());
+
+    cpu_jit_free(jit);
+    return rc;
+}
@@ -1,113 +1,151 @@
 // cpu_core.c
 // Núcleo de CPU de 8 bits para usar como biblioteca desde C
-// No tiene main(), sólo expone memoria, registros y fetch_decode_execute().
+// No tiene main(). El estado vive en contextos cpu_t (ver cpu_core.h);
+// memory[], ACC, PC, IR y fetch_decode_execute() se mantienen como API
+// global sobre el contexto por defecto.
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
-#define MEM_SIZE 256
+#include "cpu_core.h"
 
 // ---------------------------------------------------------------------
-// Memoria y registros (visibles desde otros .c)
+// Memoria y registros globales (visibles desde otros .c)
 // ---------------------------------------------------------------------
 uint8_t memory[MEM_SIZE];   // Espacio de memoria de 256 bytes
 uint8_t ACC = 0;            // Acumulador
 uint8_t PC  = 0;            // Contador de programa
 uint8_t IR  = 0;            // Registro de instrucción (opcional para depuración)
 
+// Contexto por defecto: ejecuta directamente sobre memory[]
+cpu_t cpu_default = { .mem = memory };
+
+const char *const cpu_fused_names[CPU_FUSED_COUNT] = {
+    [CPU_FUSED_LOAD_ADD_STORE] = "LOAD;ADD;STORE",
+    [CPU_FUSED_LOAD_JZ]        = "LOAD;JZ",
+    [CPU_FUSED_LOAD_STORE]     = "LOAD;STORE",
+};
+
 // ---------------------------------------------------------------------
-// ISA de 8 bits (debe coincidir con la que usa tu ensamblador)
+// Inicialización y reset de un contexto
 // ---------------------------------------------------------------------
-enum {
-    NOP   = 0x00,  // No operación
-    LOAD  = 0x01,  // ACC <- [addr]
-    ADD   = 0x02,  // ACC <- ACC + [addr]   (aritmética de 8 bits, módulo 256)
-    STORE = 0x03,  // [addr] <- ACC
-    JMP   = 0x04,  // PC <- addr
-    JZ    = 0x05,  // if ACC == 0 then PC <- addr
-    PRINT = 0x06,  // opcional: imprime ACC/PC (debug)
-    HALT  = 0xFF   // detiene ejecución
-};
+void cpu_init(cpu_t *c) {
+    memset(c->ram, 0, MEM_SIZE);
+    c->mem = c->ram;
+    memset(c->fused, 0, sizeof c->fused);
+    c->profile = NULL;
+    c->breakpoints = NULL;
+    cpu_flush(c);
+    cpu_reset(c);
+}
+
+void cpu_reset(cpu_t *c) {
+    c->ACC = 0;
+    c->PC  = 0;
+    c->IR  = 0;
+    c->C   = 0;
+    c->X   = 0;
+    c->steps = 0;
+    // NO tocamos la memoria aquí: el que carga el módulo la prepara
+}
 
 // ---------------------------------------------------------------------
-// Reset opcional de la CPU (puedes llamarlo si quieres desde C)
+// Escrituras externas y caché de decodificación
 // ---------------------------------------------------------------------
-void cpu_reset(void) {
-    ACC = 0;
-    PC  = 0;
-    IR  = 0;
-    // NO tocamos memory[] aquí, porque main2link ya la limpia con memset()
+void cpu_flush(cpu_t *c) {
+    memset(c->dec, 0, sizeof c->dec);
+    memset(c->covered, 0, sizeof c->covered);
+}
+
+void cpu_write(cpu_t *c, uint8_t addr, uint8_t value) {
+    c->mem[addr] = value;
+    cpu_dec_invalidate(c, addr);
+}
+
+void cpu_load(cpu_t *c, const uint8_t img[MEM_SIZE]) {
+    // Al recargar la misma imagen sólo difieren los bytes que escribió la
+    // ejecución anterior, así que el resto de la caché sigue siendo válida
+    for (int a = 0; a < MEM_SIZE; a += 8) {
+        uint64_t now, want;
+        memcpy(&now, c->mem + a, 8);
+        memcpy(&want, img + a, 8);
+        if (now == want) continue;
+        for (int i = a; i < a + 8; i++) {
+            if (c->mem[i] != img[i]) cpu_write(c, (uint8_t)i, img[i]);
+        }
+    }
 }
 
 // ---------------------------------------------------------------------
-// Helpers internos de fetch
+// Bucle principal de ejecución sobre un contexto
+//
+// Los registros se copian a variables locales para que el compilador
+// los mantenga en registros del host, y se escriben de vuelta al salir.
+// El cuerpo está en cpu_exec.h y se genera en varias variantes de despacho.
 // ---------------------------------------------------------------------
-static uint8_t fetch_u8(void) {
-    // PC es de 8 bits, así que la dirección es siempre 0..255 (wrap natural)
-    uint8_t value = memory[PC];
-    PC = (uint8_t)(PC + 1);   // incremento con wrap de 8 bits
-    return value;
+#define CPU_EXEC_NAME      cpu_run_switch
+#define CPU_EXEC_THREADED  0
+#include "cpu_exec.h"
+
+#if CPU_HAVE_THREADED
+#define CPU_EXEC_NAME      cpu_run_threaded
+#define CPU_EXEC_THREADED  1
+#include "cpu_exec.h"
+
+#define CPU_EXEC_NAME      cpu_run_predecoded
+#define CPU_EXEC_THREADED  1
+#define CPU_EXEC_PREDECODE 1
+#include "cpu_exec.h"
+#endif
+
+// Variantes con políticas: una por combinación de CPU_POLICY_*, con el
+// mismo despacho que el motor sin caché más rápido (cpu_policies.h).
+#include "cpu_policies.h"
+
+// [máscara] -> motor; cpu_policies.h rellena las CPU_POLICY_COUNT entradas
+static const cpu_engine_t cpu_engines[CPU_POLICY_COUNT] = {
+#define CPU_POLICIES_TABLE
+#include "cpu_policies.h"
+#undef CPU_POLICIES_TABLE
+};
+
+cpu_engine_t cpu_engine(unsigned policy) {
+    return cpu_engines[policy % CPU_POLICY_COUNT];
 }
 
-static uint8_t fetch_addr(void) {
-    return fetch_u8();        // en esta ISA, las direcciones son un byte
+// Motor por defecto, elegido al compilar
+int cpu_run(cpu_t *c) {
+#if CPU_HAVE_THREADED
+    return cpu_run_predecoded(c);
+#else
+    return cpu_run_switch(c);
+#endif
 }
 
 // ---------------------------------------------------------------------
-// Bucle principal de ejecución
+// API global heredada: capa fina sobre cpu_default
 // ---------------------------------------------------------------------
+void cpu_reset_default(void) {
+    ACC = 0;
+    PC  = 0;
+    IR  = 0;
+    cpu_default.C = 0;          // el acarreo y X no tienen global: viven en el contexto
+    cpu_default.X = 0;
+    cpu_default.steps = 0;
+    // NO tocamos memory[] aquí, porque main2link ya la limpia con memset()
+}
+
 void fetch_decode_execute(void) {
-    for (;;) {
-        IR = fetch_u8();  // fetch de opcode
-
-        switch (IR) {
-
-            case NOP:
-                // No hace nada
-                break;
-
-            case LOAD: {
-                uint8_t addr = fetch_addr();
-                ACC = memory[addr];
-            } break;
-
-            case ADD: {
-                uint8_t addr = fetch_addr();
-                ACC = (uint8_t)(ACC + memory[addr]);  // overflow natural de 8 bits
-            } break;
-
-            case STORE: {
-                uint8_t addr = fetch_addr();
-                memory[addr] = ACC;
-            } break;
-
-            case JMP: {
-                uint8_t addr = fetch_addr();
-                PC = addr;
-            } break;
-
-            case JZ: {
-                uint8_t addr = fetch_addr();
-                if (ACC == 0) {
-                    PC = addr;
-                }
-            } break;
-
-            case PRINT:
-                // Instrucción opcional de depuración
-                printf("[CPU] ACC=%3u (0x%02X), PC=0x%02X\n",
-                       ACC, ACC, PC);
-                break;
-
-            case HALT:
-                // Termina la ejecución del programa cargado en memory[]
-                return;
-
-            default:
-                // Opcode desconocido: reporta y detiene
-                printf("Unknown opcode 0x%02X at PC=0x%02X\n",
-                       IR, (uint8_t)(PC - 1));
-                return;
-        }
-    }
+    // memory[] se escribe directamente desde fuera: no hay caché fiable
+    cpu_flush(&cpu_default);
+    cpu_default.ACC = ACC;
+    cpu_default.PC  = PC;
+    cpu_default.IR  = IR;
+
+    cpu_run(&cpu_default);
+
+    ACC = cpu_default.ACC;
+    PC  = cpu_default.PC;
+    IR  = cpu_default.IR;
 }
@@ -0,0 +1,183 @@
+// cpu_core.h
+// Interfaz pública del núcleo de CPU de 8 bits (cpu_core.c).
+//
+// Dos formas de uso:
+//   - API de contexto: cada cpu_t tiene su propia memoria y registros,
+//     así que se pueden ejecutar muchos programas a la vez (un cpu_t por hilo).
+//   - API global heredada: memory[], ACC, PC, IR y fetch_decode_execute(),
+//     que ahora son una capa fina sobre el contexto por defecto cpu_default.
+
+#ifndef CPU_CORE_H
+#define CPU_CORE_H
+
+#include <stdint.h>
+
+#include "../Export_week2/isa.h"
+
+#define MEM_SIZE        256
+#define CPU_CACHE_LINE  64     // tamaño de línea de caché del host
+
+// Despacho con goto computado (direct threading) si el compilador es
+// GNU C; -DCPU_NO_THREADED fuerza el switch clásico.
+#if defined(__GNUC__) && !defined(CPU_NO_THREADED)
+#define CPU_HAVE_THREADED 1
+#else
+#define CPU_HAVE_THREADED 0
+#endif
+
+// ---------------------------------------------------------------------
+// ISA de 8 bits: la tabla ISA_TABLE de Export_week2/isa.h (la misma que
+// usa el ensamblador). Aquí los opcodes llevan su nombre sin prefijo.
+// ---------------------------------------------------------------------
+#define CPU_OPCODE(name, code, kind)  name = code,
+enum { ISA_TABLE(CPU_OPCODE) };
+#undef CPU_OPCODE
+
+// Bytes que ocupa la instrucción: 2 si lleva operando, si no 1
+static inline int cpu_insn_len(uint8_t op) {
+    return isa_insn_len(op);
+}
+
+// ---------------------------------------------------------------------
+// Caché de instrucciones decodificadas (una entrada por PC)
+//
+// handler es el handler del intérprete ya resuelto (desplazamiento dentro
+// de cpu_run_predecoded); 0 = entrada sin decodificar. arg es el operando;
+// arg2 y arg3 son los operandos de las instrucciones siguientes cuando la
+// entrada es una superinstrucción (varias instrucciones fusionadas).
+// ---------------------------------------------------------------------
+typedef struct {
+    int32_t handler;
+    uint8_t arg, arg2, arg3;
+} cpu_decoded_t;
+
+// Bytes de memoria que puede cubrir una entrada (LOAD; ADD; STORE fusionados)
+#define CPU_DEC_SPAN  6
+
+// Superinstrucciones de cpu_run_predecoded (-DCPU_NO_FUSION las desactiva)
+enum {
+    CPU_FUSED_LOAD_ADD_STORE,   // LOAD x; ADD y; STORE z
+    CPU_FUSED_LOAD_JZ,          // LOAD x; JZ l
+    CPU_FUSED_LOAD_STORE,       // LOAD x; STORE z
+    CPU_FUSED_COUNT
+};
+
+extern const char *const cpu_fused_names[CPU_FUSED_COUNT];
+
+// ---------------------------------------------------------------------
+// Perfil de ejecución (cpu_run_profile)
+//
+// Contadores por PC y por opcode, y saltos tomados / no tomados de cada
+// salto condicional (JZ, JNZ, JC). Se acumulan entre ejecuciones: quien
+// los quiera desde cero pone el struct a cero. cpu_profile.h los cruza
+// con el .lst del ensamblador.
+// ---------------------------------------------------------------------
+typedef struct {
+    uint64_t pc[MEM_SIZE];          // instrucciones ejecutadas en cada PC
+    uint64_t op[256];               // instrucciones ejecutadas de cada opcode
+    uint64_t taken[MEM_SIZE];       // saltos condicionales en ese PC que saltaron
+    uint64_t not_taken[MEM_SIZE];   // ... y que siguieron de largo
+} cpu_profile_t;
+
+// ---------------------------------------------------------------------
+// Contexto de CPU
+//
+// Alineado a línea de caché: sizeof(cpu_t) es múltiplo de CPU_CACHE_LINE,
+// de modo que dos contextos (p. ej. en un arreglo, uno por hilo) nunca
+// comparten línea y no hay false sharing.
+// ---------------------------------------------------------------------
+typedef struct cpu {
+    _Alignas(CPU_CACHE_LINE) uint8_t ram[MEM_SIZE];  // memoria propia
+    uint8_t *mem;   // memoria activa: ram, o memory[] en cpu_default
+    uint8_t  ACC;   // Acumulador
+    uint8_t  PC;    // Contador de programa
+    uint8_t  IR;    // Registro de instrucción
+    uint8_t  C;     // Flag de acarreo, 0 o 1 (ver isa.h)
+    uint8_t  X;     // Registro índice (LOADX, ADDX, STOREX)
+    uint64_t steps; // instrucciones ejecutadas desde el último reset
+    cpu_decoded_t dec[MEM_SIZE];   // caché de decodificación, indexada por PC
+    uint8_t  covered[MEM_SIZE];    // 1 = el byte pertenece a alguna entrada de dec
+                                   // (se limpia sólo con cpu_flush)
+    uint64_t fused[CPU_FUSED_COUNT];  // veces que se ejecutó cada superinstrucción
+                                      // (acumulado desde cpu_init)
+    cpu_profile_t *profile;         // contadores de CPU_POLICY_PROFILE (NULL tras cpu_init)
+    const uint8_t *breakpoints;     // [pc] != 0: CPU_POLICY_BREAK para ahí (NULL, tras cpu_init: ninguno)
+} cpu_t;
+
+// Resultado de cpu_run y de todas las variantes
+enum {
+    CPU_HALTED        =  0,     // HALT
+    CPU_BAD_OPCODE    = -1,     // opcode desconocido (PC queda detrás de él)
+    CPU_OUT_OF_BOUNDS = -2,     // CPU_POLICY_BOUNDS: la ejecución pasó de 0xFF
+    CPU_BREAKPOINT    =  1,     // CPU_POLICY_BREAK: parada antes de ejecutar PC
+};
+
+void cpu_init(cpu_t *c);    // memoria, registros y caché a cero, mem = ram
+void cpu_reset(cpu_t *c);   // ACC = PC = IR = C = X = steps = 0 (no toca la memoria)
+int  cpu_run(cpu_t *c);     // ejecuta hasta HALT (0) u opcode desconocido (-1)
+
+// Escrituras en memoria desde fuera de la CPU. Los STORE de la guest
+// mantienen la caché de decodificación al día; quien escriba c->mem
+// directamente sobre código ya ejecutado debe usar estas funciones
+// (o cpu_flush) para que no se ejecuten instrucciones viejas.
+void cpu_write(cpu_t *c, uint8_t addr, uint8_t value);
+void cpu_load(cpu_t *c, const uint8_t img[MEM_SIZE]);  // sólo invalida lo que cambia
+void cpu_flush(cpu_t *c);                               // vacía toda la caché
+
+// Invalida todas las entradas cuya instrucción (o superinstrucción)
+// incluye el byte addr. Todo STORE y toda escritura externa pasa por aquí;
+// si addr nunca se decodificó (datos) no hay nada que invalidar.
+static inline void cpu_dec_invalidate(cpu_t *c, uint8_t addr) {
+    if (!c->covered[addr]) return;
+    for (int k = 0; k < CPU_DEC_SPAN; k++)
+        c->dec[(uint8_t)(addr - k)].handler = 0;
+}
+
+// Variantes concretas del intérprete (cpu_run usa la mejor disponible:
+// predecoded si el compilador es GNU C, si no switch)
+int  cpu_run_switch(cpu_t *c);
+#if CPU_HAVE_THREADED
+int  cpu_run_threaded(cpu_t *c);
+int  cpu_run_predecoded(cpu_t *c);
+#endif
+
+// ---------------------------------------------------------------------
+// Políticas: comprobaciones opcionales del intérprete
+//
+// Cada combinación es una variante compilada aparte de cpu_exec.h, en la
+// que las comprobaciones que no pidió no existen (ni siquiera un if), así
+// que los motores de arriba no pagan nada por ellas. Se elige en tiempo
+// de ejecución con cpu_engine(). Las variantes usan el despacho threaded
+// (o switch) sin caché ni fusión, para que cada PC pase por el fetch.
+// ---------------------------------------------------------------------
+#define CPU_POLICY_TRACE    0x1     // imprime PC, IR (desensamblado), ACC, C y X de cada instrucción
+#define CPU_POLICY_BREAK    0x2     // para antes de los PCs marcados en c->breakpoints
+                                    // (al volver a llamar, el primero se ejecuta)
+#define CPU_POLICY_BOUNDS   0x4     // error si la ejecución pasa de 0xFF en vez
+                                    // de dar la vuelta a 0x00
+#define CPU_POLICY_PROFILE  0x8     // cuenta cada instrucción en c->profile
+#define CPU_POLICY_COUNT    16      // combinaciones
+
+typedef int (*cpu_engine_t)(cpu_t *c);
+
+// Variante con exactamente esas políticas; 0 = cpu_run
+cpu_engine_t cpu_engine(unsigned policy);
+
+// Intérprete con perfil (cpu_engine(CPU_POLICY_PROFILE)): como cpu_run,
+// pero además cuenta cada instrucción en c->profile, que debe apuntar a
+// un cpu_profile_t.
+int  cpu_run_profile(cpu_t *c);
+
+// ---------------------------------------------------------------------
+// API global heredada (main2link*.c)
+// ---------------------------------------------------------------------
+extern uint8_t memory[MEM_SIZE];
+extern uint8_t ACC;
+extern uint8_t PC;
+extern uint8_t IR;
+extern cpu_t   cpu_default;     // contexto cuya memoria es memory[]
+
+void cpu_reset_default(void);   // equivale a la antigua cpu_reset(void)
+void fetch_decode_execute(void);
+
+#endif // CPU_CORE_H
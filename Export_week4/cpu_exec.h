@@ -0,0 +1,458 @@
+// cpu_exec.h
+// Plantilla del bucle fetch-decode-execute.
+//
+// NO es un header normal: cpu_core.c lo incluye una vez por variante del
+// intérprete, definiendo antes:
+//   CPU_EXEC_NAME       nombre de la función generada, int f(cpu_t *)
+//                       (por defecto cpu_run_policy_<CPU_EXEC_POLICY>)
+//   CPU_EXEC_THREADED   1 = direct threading con goto computado (GNU C)
+//                       0 = switch clásico (C estándar)
+//   CPU_EXEC_PREDECODE  1 = ejecuta desde la caché de instrucciones
+//                       decodificadas c->dec[] (requiere THREADED)
+//   CPU_EXEC_POLICY     máscara de CPU_POLICY_* (cpu_core.h), 0 por defecto;
+//                       un número literal si forma el nombre por defecto.
+//                       Incompatible con PREDECODE: la caché y la fusión
+//                       se saltan el fetch de memory[] donde se comprueban
+//
+// Los cuerpos de las instrucciones se escriben una sola vez. En la
+// variante threaded, NEXT replica el fetch y el salto indirecto al final
+// de cada handler, de modo que cada instrucción de la ISA tiene su propio
+// salto indirecto y el predictor de saltos aprende las secuencias de la
+// guest (p. ej. LOAD -> ADD -> STORE del bucle INNER de factorialIN.asm).
+//
+// Con PREDECODE cada entrada c->dec[pc] guarda el handler ya resuelto
+// (como desplazamiento respecto a la etiqueta op_decode) y el operando,
+// así que el bucle no vuelve a leer ni decodificar memory[]. Una entrada
+// a cero apunta a op_decode, que la rellena al primer uso. Todo STORE
+// invalida las entradas que cubren la dirección escrita, de modo que el
+// código automodificable se vuelve a decodificar.
+//
+// Al decodificar se reconocen además las secuencias LOAD;ADD;STORE,
+// LOAD;JZ y LOAD;STORE y se guardan como una superinstrucción: un solo
+// salto indirecto ejecuta las dos o tres instrucciones. Las entradas de
+// los PCs intermedios se decodifican por separado, así que un salto al
+// medio de la secuencia ejecuta exactamente lo mismo que sin fusión.
+
+#if CPU_EXEC_PREDECODE && !CPU_EXEC_THREADED
+#error "CPU_EXEC_PREDECODE requiere CPU_EXEC_THREADED"
+#endif
+#ifndef CPU_EXEC_POLICY
+#define CPU_EXEC_POLICY 0
+#endif
+#if CPU_EXEC_PREDECODE && CPU_EXEC_POLICY
+#error "CPU_EXEC_POLICY no admite CPU_EXEC_PREDECODE"
+#endif
+#ifndef CPU_EXEC_NAME
+#define CPU_EXEC_PASTE(a, b)    a##b
+#define CPU_EXEC_XPASTE(a, b)   CPU_EXEC_PASTE(a, b)
+#define CPU_EXEC_NAME           CPU_EXEC_XPASTE(cpu_run_policy_, CPU_EXEC_POLICY)
+#endif
+
+// Ganchos de las políticas alrededor de cada fetch de opcode; los que la
+// variante no pidió no generan código.
+//   FETCH_CHECK()       antes de leer el opcode en pc
+//   FETCHED()           leído ir, pc ya apunta detrás de él
+//   COUNT_JZ(at, t)     salto condicional (JZ, JNZ, JC) en at, saltó (t = 1) o no
+#if CPU_EXEC_POLICY & CPU_POLICY_BOUNDS
+// El PC tiene más de 8 bits: pasar de 0xFF deja pc = 0x100 en vez de 0x00.
+// Un opcode en 0xFF sólo es válido si es HALT (cualquier otro sigue en 0x100).
+#define PC_T            unsigned
+#define CHECK_BOUNDS()  do { if (pc >= MEM_SIZE) goto out_of_bounds; } while (0)
+#define CHECK_OPCODE()  do { if (pc >= MEM_SIZE && ir != HALT) goto out_of_bounds; } while (0)
+#else
+#define PC_T            uint8_t     // la dirección es siempre 0..255 (wrap natural)
+#define CHECK_BOUNDS()  ((void)0)
+#define CHECK_OPCODE()  ((void)0)
+#endif
+
+#if CPU_EXEC_POLICY & CPU_POLICY_BREAK
+// No en el primer fetch de la llamada: así se continúa desde un breakpoint
+#define CHECK_BREAK()   do { if (bp[pc] && steps != steps0) { status = CPU_BREAKPOINT; goto out; } } while (0)
+#else
+#define CHECK_BREAK()   ((void)0)
+#endif
+
+#if CPU_EXEC_POLICY & CPU_POLICY_PROFILE
+#define COUNT(at)       (prof->pc[at]++, prof->op[ir]++)
+#define COUNT_JZ(at, t) ((t) ? prof->taken[at]++ : prof->not_taken[at]++)
+#else
+#define COUNT(at)       ((void)0)
+#define COUNT_JZ(at, t) ((void)0)
+#endif
+
+#if CPU_EXEC_POLICY & CPU_POLICY_TRACE
+#define TRACE(at)       do { char dis[24]; isa_disasm(dis, sizeof dis, mem, (at)); \
+                             printf("[TRACE] PC=0x%02X IR=0x%02X %-14s ACC=%3u (0x%02X) C=%u X=0x%02X steps=%llu\n", \
+                                    (at), ir, dis, acc, acc, cy, x, (unsigned long long)steps); } while (0)
+#else
+#define TRACE(at)       ((void)0)
+#endif
+
+#define FETCH_CHECK()   do { CHECK_BOUNDS(); CHECK_BREAK(); } while (0)
+#define FETCHED()       do { CHECK_OPCODE(); COUNT((uint8_t)(pc - 1)); TRACE((uint8_t)(pc - 1)); } while (0)
+
+// Las tablas de despacho tienen una entrada por fila de ISA_TABLE (isa.h):
+// una instrucción nueva sin su handler op_<NOMBRE> no compila.
+
+#if CPU_EXEC_THREADED && defined(__GNUC__) && !defined(__clang__)
+// GCC fusiona los NEXT idénticos en un único salto indirecto (cross-jumping),
+// lo que anula el threading; se desactiva sólo para esta función.
+__attribute__((optimize("no-crossjumping")))
+#endif
+int CPU_EXEC_NAME(cpu_t *c) {
+    uint8_t *mem   = c->mem;
+    uint8_t  acc   = c->ACC;
+    uint8_t  cy    = c->C;      // acarreo
+    uint8_t  x     = c->X;      // registro índice
+    PC_T     pc    = c->PC;
+    uint8_t  ir    = c->IR;
+    uint64_t steps = c->steps;
+    int status;
+#if CPU_EXEC_POLICY & CPU_POLICY_BREAK
+    static const uint8_t no_breakpoints[MEM_SIZE];
+    const uint8_t *bp = c->breakpoints ? c->breakpoints : no_breakpoints;  // NULL: ninguno
+    const uint64_t steps0 = steps;
+#endif
+#if CPU_EXEC_POLICY & CPU_POLICY_PROFILE
+    cpu_profile_t *prof = c->profile;
+#endif
+
+#if CPU_EXEC_PREDECODE
+    cpu_decoded_t *dec = c->dec;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+#define CPU_EXEC_ENTRY(name, code, kind) [code] = &&op_##name - &&op_decode,
+    static const int32_t handlers[256] = {
+        [0 ... 255] = &&op_bad - &&op_decode,
+        ISA_TABLE(CPU_EXEC_ENTRY)
+    };
+#pragma GCC diagnostic pop
+
+    cpu_decoded_t *d;
+    uint64_t fused[CPU_FUSED_COUNT] = { 0 };
+
+#define CASE(op)        op_##op:
+#define CASE_BAD        op_bad:
+#define NEXT            do { d = &dec[pc++]; steps++; goto *(&&op_decode + d->handler); } while (0)
+#define ARG()           (pc++, d->arg)
+#define OPCODE()        mem[(uint8_t)(d - dec)]
+
+    NEXT;   // primer fetch
+
+op_decode: {
+        // Entrada sin decodificar: se resuelve una vez y se reutiliza
+        uint8_t at = (uint8_t)(d - dec);
+        uint8_t op = mem[at];
+        d->handler = handlers[op];
+        d->arg     = mem[(uint8_t)(at + 1)];
+        for (int k = 0; k < CPU_DEC_SPAN; k++)  // cubre el mayor tamaño posible
+            c->covered[(uint8_t)(at + k)] = 1;
+#ifndef CPU_NO_FUSION
+        if (op == LOAD) {
+            uint8_t op2 = mem[(uint8_t)(at + 2)];
+            d->arg2 = mem[(uint8_t)(at + 3)];
+            if (op2 == ADD && mem[(uint8_t)(at + 4)] == STORE) {
+                d->handler = &&op_LOAD_ADD_STORE - &&op_decode;
+                d->arg3    = mem[(uint8_t)(at + 5)];
+            } else if (op2 == JZ) {
+                d->handler = &&op_LOAD_JZ - &&op_decode;
+            } else if (op2 == STORE) {
+                d->handler = &&op_LOAD_STORE - &&op_decode;
+            }
+        }
+#endif
+        goto *(&&op_decode + d->handler);
+    }
+
+#ifndef CPU_NO_FUSION
+    // Superinstrucciones. Al entrar, NEXT ya avanzó pc al primer operando
+    // y contó la primera instrucción.
+op_LOAD_ADD_STORE: {
+        unsigned sum = mem[d->arg] + mem[d->arg2];
+        acc = (uint8_t)sum;
+        cy  = sum >> 8;
+        uint8_t addr = d->arg3;
+        mem[addr] = acc;
+        cpu_dec_invalidate(c, addr);
+        pc = (uint8_t)(pc + 5);
+        steps += 2;
+        fused[CPU_FUSED_LOAD_ADD_STORE]++;
+    } NEXT;
+
+op_LOAD_JZ:
+        acc = mem[d->arg];
+        pc = acc == 0 ? d->arg2 : (uint8_t)(pc + 3);
+        steps += 1;
+        fused[CPU_FUSED_LOAD_JZ]++;
+        NEXT;
+
+op_LOAD_STORE: {
+        acc = mem[d->arg];
+        uint8_t addr = d->arg2;
+        mem[addr] = acc;
+        cpu_dec_invalidate(c, addr);
+        pc = (uint8_t)(pc + 3);
+        steps += 1;
+        fused[CPU_FUSED_LOAD_STORE]++;
+    } NEXT;
+#endif
+
+#elif CPU_EXEC_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+#define CPU_EXEC_ENTRY(name, code, kind) [code] = &&op_##name,
+    static const void *const dispatch[256] = {
+        [0 ... 255] = &&op_bad,
+        ISA_TABLE(CPU_EXEC_ENTRY)
+    };
+#pragma GCC diagnostic pop
+
+#define CASE(op)        op_##op:
+#define CASE_BAD        op_bad:
+#define NEXT            do { FETCH_CHECK(); ir = mem[pc++]; FETCHED(); steps++; goto *dispatch[ir]; } while (0)
+#define ARG()           mem[pc++]
+#define OPCODE()        ir
+
+    NEXT;   // primer fetch
+#else
+#define CASE(op)        case op:
+#define CASE_BAD        default:
+#define NEXT            continue
+#define ARG()           mem[pc++]
+#define OPCODE()        ir
+
+    for (;;) {
+        FETCH_CHECK();
+        ir = mem[pc++];  // fetch de opcode
+        FETCHED();
+        steps++;
+
+        switch (ir) {
+#endif
+
+        CASE(NOP)
+            // No hace nada
+            NEXT;
+
+        CASE(LOAD) {
+            uint8_t addr = ARG();
+            acc = mem[addr];
+        } NEXT;
+
+        // Sumas y restas: el acarreo (o préstamo) es el bit 8 del
+        // resultado calculado en unsigned
+        CASE(ADD) {
+            uint8_t addr = ARG();
+            unsigned sum = acc + mem[addr];
+            acc = (uint8_t)sum;                 // overflow natural de 8 bits
+            cy  = sum >> 8;
+        } NEXT;
+
+        CASE(ADC) {
+            uint8_t addr = ARG();
+            unsigned sum = acc + mem[addr] + cy;
+            acc = (uint8_t)sum;
+            cy  = sum >> 8;
+        } NEXT;
+
+        CASE(MUL) {
+            uint8_t addr = ARG();
+            acc = (uint8_t)(acc * mem[addr]);  // byte bajo del producto
+        } NEXT;
+
+        CASE(SUB) {
+            uint8_t addr = ARG();
+            unsigned dif = acc - mem[addr];     // bit 8 = 1 si hubo préstamo
+            acc = (uint8_t)dif;
+            cy  = (dif >> 8) & 1;
+        } NEXT;
+
+        CASE(SBC) {
+            uint8_t addr = ARG();
+            unsigned dif = acc - mem[addr] - cy;
+            acc = (uint8_t)dif;
+            cy  = (dif >> 8) & 1;
+        } NEXT;
+
+        CASE(LOADI)
+            acc = ARG();
+            NEXT;
+
+        CASE(ADDI) {
+            unsigned sum = acc + ARG();
+            acc = (uint8_t)sum;
+            cy  = sum >> 8;
+        } NEXT;
+
+        CASE(SUBI) {
+            unsigned dif = acc - ARG();
+            acc = (uint8_t)dif;
+            cy  = (dif >> 8) & 1;
+        } NEXT;
+
+        CASE(STORE) {
+            uint8_t addr = ARG();
+            mem[addr] = acc;
+            // addr puede ser el opcode de una instrucción, el operando de la
+            // anterior o parte de una superinstrucción: se decodifican de nuevo
+            cpu_dec_invalidate(c, addr);
+        } NEXT;
+
+        // Por puntero: el operando es la dirección del byte que guarda la
+        // dirección del dato
+        CASE(LOADP) {
+            uint8_t ptr = ARG();
+            acc = mem[mem[ptr]];
+        } NEXT;
+
+        CASE(ADDP) {
+            uint8_t ptr = ARG();
+            unsigned sum = acc + mem[mem[ptr]];
+            acc = (uint8_t)sum;
+            cy  = sum >> 8;
+        } NEXT;
+
+        CASE(STOREP) {
+            uint8_t ptr = ARG();
+            uint8_t addr = mem[ptr];
+            mem[addr] = acc;
+            cpu_dec_invalidate(c, addr);    // como STORE: puede ser código
+        } NEXT;
+
+        // Indexadas: operando + X, con la vuelta en 256 como el PC
+        CASE(LOADX) {
+            uint8_t addr = (uint8_t)(ARG() + x);
+            acc = mem[addr];
+        } NEXT;
+
+        CASE(ADDX) {
+            uint8_t addr = (uint8_t)(ARG() + x);
+            unsigned sum = acc + mem[addr];
+            acc = (uint8_t)sum;
+            cy  = sum >> 8;
+        } NEXT;
+
+        CASE(STOREX) {
+            uint8_t addr = (uint8_t)(ARG() + x);
+            mem[addr] = acc;
+            cpu_dec_invalidate(c, addr);
+        } NEXT;
+
+        CASE(INX)
+            x++;
+            NEXT;
+
+        CASE(DEX)
+            x--;
+            NEXT;
+
+        CASE(TAX)
+            x = acc;
+            NEXT;
+
+        CASE(TXA)
+            acc = x;
+            NEXT;
+
+        CASE(JMP) {
+            uint8_t addr = ARG();
+            pc = addr;
+        } NEXT;
+
+        CASE(JZ) {
+            uint8_t addr = ARG();
+            if (acc == 0) {
+                // NEXT propio: un salto condicional, no un cmov que haría
+                // esperar al siguiente despacho por el valor de ACC
+                COUNT_JZ((uint8_t)(pc - 2), 1);
+                pc = addr;
+                NEXT;
+            }
+            COUNT_JZ((uint8_t)(pc - 2), 0);
+        } NEXT;
+
+        CASE(JNZ) {
+            uint8_t addr = ARG();
+            if (acc != 0) {
+                COUNT_JZ((uint8_t)(pc - 2), 1);
+                pc = addr;
+                NEXT;
+            }
+            COUNT_JZ((uint8_t)(pc - 2), 0);
+        } NEXT;
+
+        CASE(JC) {
+            uint8_t addr = ARG();
+            if (cy) {
+                COUNT_JZ((uint8_t)(pc - 2), 1);
+                pc = addr;
+                NEXT;
+            }
+            COUNT_JZ((uint8_t)(pc - 2), 0);
+        } NEXT;
+
+        CASE(PRINT)
+            // Instrucción opcional de depuración
+            printf("[CPU] ACC=%3u (0x%02X), PC=0x%02X\n",
+                   acc, acc, pc);
+            NEXT;
+
+        CASE(HALT)
+            // Termina la ejecución del programa cargado en memoria
+            ir = OPCODE();
+            status = CPU_HALTED;
+            goto out;
+
+        CASE_BAD
+            // Opcode desconocido: reporta y detiene
+            ir = OPCODE();
+            printf("Unknown opcode 0x%02X at PC=0x%02X\n",
+                   ir, (uint8_t)(pc - 1));
+            status = CPU_BAD_OPCODE;
+            goto out;
+
+#if !CPU_EXEC_THREADED
+        }
+    }
+#endif
+
+#if CPU_EXEC_POLICY & CPU_POLICY_BOUNDS
+out_of_bounds:
+    printf("PC out of bounds: execution ran past 0x%02X\n", MEM_SIZE - 1);
+    status = CPU_OUT_OF_BOUNDS;
+    goto out;
+#endif
+
+out:
+    c->ACC   = acc;
+    c->C     = cy;
+    c->X     = x;
+    c->PC    = (uint8_t)pc;
+    c->IR    = ir;
+    c->steps = steps;
+#if CPU_EXEC_PREDECODE
+    for (int k = 0; k < CPU_FUSED_COUNT; k++)
+        c->fused[k] += fused[k];
+#endif
+    return status;
+}
+
+#undef CASE
+#undef CASE_BAD
+#undef NEXT
+#undef ARG
+#undef OPCODE
+#undef PC_T
+#undef FETCH_CHECK
+#undef FETCHED
+#undef CHECK_BOUNDS
+#undef CHECK_OPCODE
+#undef CHECK_BREAK
+#undef COUNT
+#undef COUNT_JZ
+#undef TRACE
+#undef CPU_EXEC_ENTRY
+#undef CPU_EXEC_NAME
+#undef CPU_EXEC_THREADED
+#undef CPU_EXEC_PREDECODE
+#undef CPU_EXEC_POLICY
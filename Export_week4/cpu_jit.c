@@ -0,0 +1,584 @@
+// cpu_jit.c
+// x86-64 JIT for the 8-bit CPU (see cpu_jit.h).
+//
+// Host register use inside generated code:
+//   al   guest ACC                 rbx  guest memory (c->mem)
+//   r12  jit_state_t               r13  code map (1 = translated byte)
+//   r14  steps counter             r15  c->dec (decode cache, see STORE)
+//   edx  always 0                  edi  guest X (0..255)
+//   esi  guest carry (0/1): setc after every add/sub, bt before adc/sbb
+//   ecx  data address of LOADP/LOADX..., exit info on the way out
+//
+// Every block ends in exits. An exit loads ecx with
+//   next PC | reason << 8 | extra << 16
+// and jumps to the common exit stub, which returns that value to the
+// dispatcher. For EXIT_BRANCH the extra field is the id of the 10-byte
+// exit slot; once the target block exists the dispatcher overwrites the
+// slot's "mov ecx" with "jmp target" and later runs go straight there.
+//
+// Every branch out of a block is a slot, also the ones emitted as a direct
+// jmp, and each slot knows its block and its target. A store into code
+// drops only the blocks that read that byte (owner[]): the slots that
+// jump into them are turned back into exits and their own slots are
+// freed. Their machine code stays in buf, dead, until the buffer fills
+// and everything is flushed. A byte that has been changed this way is
+// marked in smc[]; as the operand of a LOAD, ADD or STORE it is then read
+// at run time (the LOADP/ADDP/STOREP of the operand byte) instead of being
+// compiled in, so a loop that walks a table by patching its own operand
+// stops invalidating its block on every iteration.
+//
+// W^X: buf is never writable and executable at once. It is mapped RW,
+// translate() and the slot patching make it writable with jit_protect()
+// and cpu_jit_run() makes it executable again just before entering
+// generated code, so a run of writes between two entries costs one pair
+// of mprotect() calls and a chained loop that writes nothing costs none.
+
+#define _DEFAULT_SOURCE     // MAP_ANONYMOUS
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CPU_JIT_X86_64 1
+#include <sys/mman.h>
+#else
+#define CPU_JIT_X86_64 0
+#endif
+
+#if CPU_JIT_X86_64
+
+#define JIT_BUF_SIZE        (4u << 20)  // 256 blocks * JIT_MAX_BLOCK_BYTES fits
+#define JIT_MAX_BLOCK_INSNS 64          // longer straight-line runs are split
+#define JIT_MAX_BLOCK_BYTES 8192        // worst case: 64 STOREs + 2 slots
+#define JIT_MAX_SLOTS       (2 * MEM_SIZE + 1)  // <= 2 per live block, id 0 unused
+
+enum {
+    EXIT_BRANCH = 1,    // continue at PC (patchable if extra != 0)
+    EXIT_SMC,           // STORE hit translated code at extra: drop its blocks
+    EXIT_PRINT,         // PRINT executed in C, continue at PC
+    EXIT_HALT,
+    EXIT_BAD,           // unknown opcode in extra
+    EXIT_STORE          // STOREP/STOREX hit code (translated or decoded) at extra
+};
+
+// Guest state shared with generated code; offsets are hard-coded in the
+// entry and exit stubs below.
+typedef struct {
+    uint64_t acc;           // +0   (low byte)
+    uint8_t *map;           // +8
+    uint64_t steps;         // +16
+    cpu_decoded_t *dec;     // +24
+    uint64_t carry;         // +32  (low byte)
+    uint64_t x;             // +40  (low byte)
+} jit_state_t;
+
+typedef uint32_t (*jit_enter_fn)(uint8_t *mem, jit_state_t *st, const uint8_t *code);
+
+struct cpu_jit {
+    uint8_t *buf;
+    size_t   used;                      // bytes of buf in use
+    size_t   code_start;                // first byte after the stubs
+    jit_enter_fn enter;
+    uint8_t *exit_stub;
+    uint8_t *block[MEM_SIZE];           // translated block starting at PC
+    uint64_t owner[MEM_SIZE][MEM_SIZE / 64];    // [addr]: starts of the
+                                                // blocks that read it
+    uint8_t  map[MEM_SIZE];             // 1 = byte read by some translation
+    uint8_t  snap[MEM_SIZE];            // its value when translated
+    uint8_t  smc[MEM_SIZE];             // 1 = changed while translated
+    uint8_t *slot[JIT_MAX_SLOTS];       // branch exits, by id (NULL = free)
+    uint8_t  slot_block[JIT_MAX_SLOTS]; // block the slot belongs to
+    uint8_t  slot_target[JIT_MAX_SLOTS];// guest PC it goes to
+    uint8_t  slot_linked[JIT_MAX_SLOTS];// 1 = patched to jmp block[target]
+    uint16_t free_slot[JIT_MAX_SLOTS];  // ids freed by dropped blocks
+    unsigned nfree;
+    unsigned nslots;                    // highest id handed out
+    unsigned gen;                       // bumped by every flush
+    int      writable;                  // 1 = buf is RW, 0 = RX
+};
+
+// Switches buf between RW and RX. Always the whole mapping, so the call
+// never splits it and cannot run out of memory; failing means the
+// protections this process relies on are gone, which is fatal.
+static void jit_protect(cpu_jit_t *j, int writable) {
+    if (j->writable == writable) return;
+    if (mprotect(j->buf, JIT_BUF_SIZE,
+                 writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) != 0) {
+        perror("cpu_jit: mprotect");
+        abort();
+    }
+    j->writable = writable;
+}
+
+// ---------------------------------------------------------------------
+// Code emission
+// ---------------------------------------------------------------------
+#define B(x)    (*p++ = (uint8_t)(x))
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    memcpy(p, &v, 4);
+    return p + 4;
+}
+
+// jmp rel32 to target
+static uint8_t *put_jmp(uint8_t *p, const uint8_t *target) {
+    B(0xE9);
+    return put32(p, (uint32_t)(int32_t)(target - (p + 4)));
+}
+
+// add r14, n (steps executed since the last update)
+static uint8_t *put_steps(uint8_t *p, uint32_t *pending) {
+    if (*pending) {
+        B(0x49); B(0x81); B(0xC6);
+        p = put32(p, *pending);
+        *pending = 0;
+    }
+    return p;
+}
+
+// setc sil: the carry (or borrow) of the add/sub just emitted
+static uint8_t *put_setc(uint8_t *p) {
+    B(0x40); B(0x0F); B(0x92); B(0xC6);
+    return p;
+}
+
+// bt esi, 0: host CF = guest carry, for adc/sbb
+static uint8_t *put_getc(uint8_t *p) {
+    B(0x0F); B(0xBA); B(0xE6); B(0);
+    return p;
+}
+
+// mov ecx, info; jmp exit_stub       (10 bytes)
+static uint8_t *put_exit(cpu_jit_t *j, uint8_t *p, uint32_t info) {
+    B(0xB9);
+    p = put32(p, info);
+    return put_jmp(p, j->exit_stub);
+}
+
+// The same with the address in ecx as the extra field:
+// shl ecx, 16; or ecx, info; jmp exit_stub       (14 bytes)
+static uint8_t *put_exit_addr(cpu_jit_t *j, uint8_t *p, uint32_t info) {
+    B(0xC1); B(0xE1); B(16);
+    B(0x81); B(0xC9);
+    p = put32(p, info);
+    return put_jmp(p, j->exit_stub);
+}
+
+// ecx = address of the data byte: mem[addr] for LOADP/ADDP/STOREP,
+// (addr + X) & 0xFF for LOADX/ADDX/STOREX
+static uint8_t *put_ea(uint8_t *p, uint8_t op, uint8_t addr) {
+    if (isa_kind(op) == ISA_PTR) {
+        B(0x0F); B(0xB6); B(0x8B); p = put32(p, addr);  // movzx ecx, byte [rbx+addr]
+    } else {
+        B(0x8D); B(0x8F); p = put32(p, addr);           // lea ecx, [rdi+addr]
+        B(0x0F); B(0xB6); B(0xC9);                      // movzx ecx, cl
+    }
+    return p;
+}
+
+// Exit of block start to another guest PC: a direct jmp if the block
+// already exists, otherwise an exit to the dispatcher. Either way a slot,
+// so dropping the target can turn it back into an exit.
+static uint8_t *put_branch(cpu_jit_t *j, uint8_t *p, uint8_t start, uint8_t target) {
+    unsigned id = j->nfree ? j->free_slot[--j->nfree] : ++j->nslots;
+    j->slot[id] = p;
+    j->slot_block[id]  = start;
+    j->slot_target[id] = target;
+    j->slot_linked[id] = j->block[target] != NULL;
+    if (j->block[target]) {
+        p = put_jmp(p, j->block[target]);
+        memset(p, 0xCC, 5);             // keep slots a fixed size
+        return p + 5;
+    }
+    return put_exit(j, p, target | EXIT_BRANCH << 8 | (uint32_t)id << 16);
+}
+
+static void emit_stubs(cpu_jit_t *j) {
+    uint8_t *p = j->buf;
+
+    // uint32_t enter(mem = rdi, st = rsi, code = rdx)
+    j->enter = (jit_enter_fn)(void *)p;
+    B(0x53);                                    // push rbx
+    B(0x41); B(0x54);                           // push r12
+    B(0x41); B(0x55);                           // push r13
+    B(0x41); B(0x56);                           // push r14
+    B(0x41); B(0x57);                           // push r15
+    B(0x48); B(0x89); B(0xFB);                  // mov rbx, rdi
+    B(0x49); B(0x89); B(0xF4);                  // mov r12, rsi
+    B(0x41); B(0x0F); B(0xB6); B(0x04); B(0x24);// movzx eax, byte [r12]
+    B(0x4D); B(0x8B); B(0x6C); B(0x24); B(8);   // mov r13, [r12+8]
+    B(0x4D); B(0x8B); B(0x74); B(0x24); B(16);  // mov r14, [r12+16]
+    B(0x4D); B(0x8B); B(0x7C); B(0x24); B(24);  // mov r15, [r12+24]
+    B(0x41); B(0x0F); B(0xB6); B(0x74); B(0x24); B(32);  // movzx esi, byte [r12+32]
+    B(0x41); B(0x0F); B(0xB6); B(0x7C); B(0x24); B(40);  // movzx edi, byte [r12+40]
+    B(0x48); B(0x89); B(0xD1);                  // mov rcx, rdx
+    B(0x31); B(0xD2);                           // xor edx, edx
+    B(0xFF); B(0xE1);                           // jmp rcx
+
+    // exit: ecx = info
+    j->exit_stub = p;
+    B(0x41); B(0x88); B(0x04); B(0x24);         // mov [r12], al
+    B(0x4D); B(0x89); B(0x74); B(0x24); B(16);  // mov [r12+16], r14
+    B(0x41); B(0x88); B(0x74); B(0x24); B(32);  // mov [r12+32], sil
+    B(0x41); B(0x88); B(0x7C); B(0x24); B(40);  // mov [r12+40], dil
+    B(0x89); B(0xC8);                           // mov eax, ecx
+    B(0x41); B(0x5F);                           // pop r15
+    B(0x41); B(0x5E);                           // pop r14
+    B(0x41); B(0x5D);                           // pop r13
+    B(0x41); B(0x5C);                           // pop r12
+    B(0x5B);                                    // pop rbx
+    B(0xC3);                                    // ret
+
+    j->code_start = j->used = (size_t)(p - j->buf);
+}
+
+// ---------------------------------------------------------------------
+// Translation of one guest basic block
+// ---------------------------------------------------------------------
+static void mark(cpu_jit_t *j, const uint8_t *mem, uint8_t addr, uint8_t start) {
+    j->owner[addr][start >> 6] |= (uint64_t)1 << (start & 63);
+    j->map[addr]  = 1;
+    j->snap[addr] = mem[addr];
+}
+
+// Drops the block starting at start: the slots that jump into it exit to
+// the dispatcher again, its own slots are freed and its bytes forget it
+static void drop_block(cpu_jit_t *j, uint8_t start) {
+    for (unsigned id = 1; id <= j->nslots; id++) {
+        if (!j->slot[id]) continue;
+        if (j->slot_block[id] == start) {
+            j->slot[id] = NULL;
+            j->free_slot[j->nfree++] = (uint16_t)id;
+        } else if (j->slot_linked[id] && j->slot_target[id] == start) {
+            jit_protect(j, 1);
+            put_exit(j, j->slot[id], start | EXIT_BRANCH << 8 | (uint32_t)id << 16);
+            j->slot_linked[id] = 0;
+        }
+    }
+
+    uint64_t bit = (uint64_t)1 << (start & 63);
+    for (int a = 0; a < MEM_SIZE; a++) {
+        uint64_t *o = j->owner[a];
+        if (!(o[start >> 6] & bit)) continue;
+        o[start >> 6] &= ~bit;
+        uint64_t any = 0;
+        for (int w = 0; w < MEM_SIZE / 64; w++) any |= o[w];
+        j->map[a] = any != 0;
+    }
+    j->block[start] = NULL;
+}
+
+// Drops every block that read addr
+static void invalidate(cpu_jit_t *j, uint8_t addr) {
+    uint64_t o[MEM_SIZE / 64];
+    j->smc[addr] = 1;
+    memcpy(o, j->owner[addr], sizeof o);
+    for (int w = 0; w < MEM_SIZE / 64; w++) {
+        for (; o[w]; o[w] &= o[w] - 1)
+            drop_block(j, (uint8_t)(w * 64 + __builtin_ctzll(o[w])));
+    }
+}
+
+// Returns NULL if the buffer is full (caller flushes and retries).
+static uint8_t *translate(cpu_jit_t *j, const uint8_t *mem, uint8_t start) {
+    if (JIT_BUF_SIZE - j->used < JIT_MAX_BLOCK_BYTES ||
+        j->nfree + (JIT_MAX_SLOTS - 1 - j->nslots) < 2)
+        return NULL;
+
+    jit_protect(j, 1);
+    uint8_t *code = j->buf + j->used, *p = code;
+    uint8_t  pc = start;
+    uint32_t pending = 0;       // guest instructions not yet added to r14
+
+    j->block[start] = code;     // self-loops become direct jumps
+
+    for (int n = 0; ; n++) {
+        if (n == JIT_MAX_BLOCK_INSNS) {
+            p = put_steps(p, &pending);
+            p = put_branch(j, p, start, pc);
+            break;
+        }
+
+        uint8_t at = pc;
+        uint8_t op = mem[pc++];
+        mark(j, mem, at, start);
+        pending++;
+
+        uint8_t addr = mem[pc];
+        if (cpu_insn_len(op) == 2) {
+            if (j->smc[pc] && (op == LOAD || op == ADD || op == STORE)) {
+                // operand read at run time, through the byte that holds it
+                op   = op == LOAD ? LOADP : op == ADD ? ADDP : STOREP;
+                addr = pc;
+            } else {
+                mark(j, mem, pc, start);
+            }
+            pc++;
+        }
+
+        if (op == NOP) {
+            continue;
+        } else if (op == LOAD) {
+            B(0x8A); B(0x83); p = put32(p, addr);       // mov al, [rbx+addr]
+            continue;
+        } else if (op == ADD) {
+            B(0x02); B(0x83); p = put32(p, addr);       // add al, [rbx+addr]
+            p = put_setc(p);
+            continue;
+        } else if (op == ADC) {
+            p = put_getc(p);
+            B(0x12); B(0x83); p = put32(p, addr);       // adc al, [rbx+addr]
+            p = put_setc(p);
+            continue;
+        } else if (op == MUL) {
+            B(0xF6); B(0xA3); p = put32(p, addr);       // mul byte [rbx+addr] (ax = al * m8)
+            continue;
+        } else if (op == SUB) {
+            B(0x2A); B(0x83); p = put32(p, addr);       // sub al, [rbx+addr]
+            p = put_setc(p);
+            continue;
+        } else if (op == SBC) {
+            p = put_getc(p);
+            B(0x1A); B(0x83); p = put32(p, addr);       // sbb al, [rbx+addr]
+            p = put_setc(p);
+            continue;
+        } else if (op == LOADI) {
+            B(0xB0); B(addr);                           // mov al, imm8
+            continue;
+        } else if (op == ADDI) {
+            B(0x04); B(addr);                           // add al, imm8
+            p = put_setc(p);
+            continue;
+        } else if (op == SUBI) {
+            B(0x2C); B(addr);                           // sub al, imm8
+            p = put_setc(p);
+            continue;
+        } else if (op == STORE) {
+            B(0x88); B(0x83); p = put32(p, addr);       // mov [rbx+addr], al
+            // keep the interpreters' decode cache coherent, as they do
+            // (cpu_dec_invalidate): cmp byte [r15+covered+addr], 0
+            B(0x41); B(0x80); B(0xBF);
+            p = put32(p, (uint32_t)(offsetof(cpu_t, covered) - offsetof(cpu_t, dec)) + addr);
+            B(0);
+            B(0x74); B(CPU_DEC_SPAN * 7);               // je over the stores
+            for (int k = 0; k < CPU_DEC_SPAN; k++) {
+                B(0x41); B(0x89); B(0x97);              // mov [r15+..], edx
+                p = put32(p, (uint8_t)(addr - k) * (uint32_t)sizeof(cpu_decoded_t));
+            }
+            p = put_steps(p, &pending);
+            B(0x41); B(0x80); B(0xBD);                  // cmp byte [r13+addr], 0
+            p = put32(p, addr);
+            B(0);
+            B(0x74); B(10);                             // je +10
+            p = put_exit(j, p, pc | EXIT_SMC << 8 | (uint32_t)addr << 16);
+            continue;
+        } else if (op == LOADP || op == LOADX) {
+            p = put_ea(p, op, addr);
+            B(0x8A); B(0x04); B(0x0B);                  // mov al, [rbx+rcx]
+            continue;
+        } else if (op == ADDP || op == ADDX) {
+            p = put_ea(p, op, addr);
+            B(0x02); B(0x04); B(0x0B);                  // add al, [rbx+rcx]
+            p = put_setc(p);
+            continue;
+        } else if (op == STOREP || op == STOREX) {
+            // the address is only known now: if it is code (translated,
+            // or in the interpreters' decode cache) the dispatcher sorts
+            // it out
+            p = put_ea(p, op, addr);
+            B(0x88); B(0x04); B(0x0B);                  // mov [rbx+rcx], al
+            p = put_steps(p, &pending);
+            B(0x41); B(0x80); B(0x7C); B(0x0D); B(0); B(0);  // cmp byte [r13+rcx], 0
+            B(0x75); B(11);                             // jne to the exit
+            B(0x41); B(0x80); B(0xBC); B(0x0F);         // cmp byte [r15+rcx+covered], 0
+            p = put32(p, (uint32_t)(offsetof(cpu_t, covered) - offsetof(cpu_t, dec)));
+            B(0);
+            B(0x74); B(14);                             // je over the exit
+            p = put_exit_addr(j, p, pc | EXIT_STORE << 8);
+            continue;
+        } else if (op == INX) {
+            B(0x40); B(0xFE); B(0xC7);                  // inc dil
+            continue;
+        } else if (op == DEX) {
+            B(0x40); B(0xFE); B(0xCF);                  // dec dil
+            continue;
+        } else if (op == TAX) {
+            B(0x0F); B(0xB6); B(0xF8);                  // movzx edi, al
+            continue;
+        } else if (op == TXA) {
+            B(0x89); B(0xF8);                           // mov eax, edi
+            continue;
+        }
+
+        // Everything else ends the block
+        p = put_steps(p, &pending);
+        if (op == JMP) {
+            p = put_branch(j, p, start, addr);
+        } else if (op == JZ) {
+            B(0x84); B(0xC0);                           // test al, al
+            B(0x75); B(10);                             // jnz +10
+            p = put_branch(j, p, start, addr);
+            p = put_branch(j, p, start, pc);
+        } else if (op == JNZ) {
+            B(0x84); B(0xC0);                           // test al, al
+            B(0x74); B(10);                             // jz +10
+            p = put_branch(j, p, start, addr);
+            p = put_branch(j, p, start, pc);
+        } else if (op == JC) {
+            B(0x85); B(0xF6);                           // test esi, esi
+            B(0x74); B(10);                             // jz +10
+            p = put_branch(j, p, start, addr);
+            p = put_branch(j, p, start, pc);
+        } else if (op == PRINT) {
+            p = put_exit(j, p, pc | EXIT_PRINT << 8);
+        } else if (op == HALT) {
+            p = put_exit(j, p, pc | EXIT_HALT << 8);
+        } else {
+            p = put_exit(j, p, pc | EXIT_BAD << 8 | (uint32_t)op << 16);
+        }
+        break;
+    }
+
+    j->used = (size_t)(p - j->buf);
+    return code;
+}
+
+// ---------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------
+cpu_jit_t *cpu_jit_new(void) {
+    cpu_jit_t *j = calloc(1, sizeof *j);
+    if (!j) return NULL;
+    void *buf = mmap(NULL, JIT_BUF_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        free(j);
+        return NULL;
+    }
+    j->buf = buf;
+    j->writable = 1;
+    emit_stubs(j);
+    // A system that refuses executable pages gets no JIT, as without mmap
+    if (mprotect(buf, JIT_BUF_SIZE, PROT_READ | PROT_EXEC) != 0) {
+        munmap(buf, JIT_BUF_SIZE);
+        free(j);
+        return NULL;
+    }
+    j->writable = 0;
+    return j;
+}
+
+void cpu_jit_free(cpu_jit_t *j) {
+    if (!j) return;
+    munmap(j->buf, JIT_BUF_SIZE);
+    free(j);
+}
+
+void cpu_jit_flush(cpu_jit_t *j) {
+    if (!j) return;
+    j->used = j->code_start;
+    memset(j->block, 0, sizeof j->block);
+    memset(j->owner, 0, sizeof j->owner);
+    memset(j->map, 0, sizeof j->map);
+    memset(j->slot, 0, sizeof j->slot);
+    memset(j->smc, 0, sizeof j->smc);
+    j->nslots = j->nfree = 0;
+    j->gen++;
+}
+
+// Translations are only valid for the bytes they were made from; the
+// host (cpu_load, cpu_write, another image) may have changed some of them.
+static void drop_stale(cpu_jit_t *j, const uint8_t *mem) {
+    uint8_t diff = 0;
+    for (int a = 0; a < MEM_SIZE; a++)
+        diff |= (uint8_t)((mem[a] ^ j->snap[a]) & -j->map[a]);
+    if (!diff) return;
+    for (int a = 0; a < MEM_SIZE; a++)
+        if (j->map[a] && mem[a] != j->snap[a]) invalidate(j, (uint8_t)a);
+}
+
+int cpu_jit_run(cpu_jit_t *j, cpu_t *c) {
+    if (!j) return cpu_run(c);
+    drop_stale(j, c->mem);
+
+    jit_state_t st = { c->ACC, j->map, c->steps, c->dec, c->C, c->X };
+    uint8_t  pc = c->PC;
+    uint32_t info;
+    int status;
+
+    for (;;) {
+        uint8_t *code = j->block[pc];
+        if (!code && !(code = translate(j, c->mem, pc))) {
+            cpu_jit_flush(j);
+            code = translate(j, c->mem, pc);
+        }
+
+        jit_protect(j, 0);
+        info = j->enter(c->mem, &st, code);
+        pc = (uint8_t)info;
+
+        switch ((info >> 8) & 0xFF) {
+        case EXIT_BRANCH: {
+            unsigned id = info >> 16, gen = j->gen;
+            if (!id) break;
+            uint8_t *target = j->block[pc];
+            if (!target) target = translate(j, c->mem, pc);
+            if (target && gen == j->gen) {
+                jit_protect(j, 1);
+                put_jmp(j->slot[id], target);   // chain: never exits here again
+                j->slot_linked[id] = 1;
+            }
+            break;
+        }
+        case EXIT_SMC:
+            invalidate(j, (uint8_t)(info >> 16));
+            break;
+        case EXIT_STORE: {
+            uint8_t addr = (uint8_t)(info >> 16);
+            cpu_dec_invalidate(c, addr);
+            if (j->map[addr]) invalidate(j, addr);
+            break;
+        }
+        case EXIT_PRINT:
+            printf("[CPU] ACC=%3u (0x%02X), PC=0x%02X\n",
+                   (uint8_t)st.acc, (uint8_t)st.acc, pc);
+            break;
+        case EXIT_HALT:
+            c->IR = HALT;
+            status = 0;
+            goto out;
+        default:
+            c->IR = (uint8_t)(info >> 16);
+            printf("Unknown opcode 0x%02X at PC=0x%02X\n",
+                   c->IR, (uint8_t)(pc - 1));
+            status = -1;
+            goto out;
+        }
+    }
+
+out:
+    c->ACC   = (uint8_t)st.acc;
+    c->C     = (uint8_t)st.carry;
+    c->X     = (uint8_t)st.x;
+    c->PC    = pc;
+    c->steps = st.steps;
+    return status;
+}
+
+#else // !CPU_JIT_X86_64
+
+cpu_jit_t *cpu_jit_new(void) { return NULL; }
+void cpu_jit_free(cpu_jit_t *j) { (void)j; }
+void cpu_jit_flush(cpu_jit_t *j) { (void)j; }
+
+int cpu_jit_run(cpu_jit_t *j, cpu_t *c) {
+    (void)j;
+    return cpu_run(c);
+}
+
+#endif
@@ -0,0 +1,40 @@
+// cpu_jit.h
+// x86-64 JIT back end for cpu_core.c.
+//
+// Guest basic blocks (split at jump targets and after every jump, PRINT
+// and HALT) are translated to x86-64 machine code in an mmap'd executable
+// buffer, on first execution. ACC lives in AL, the carry flag in ESI,
+// X in EDI, guest memory is addressed as [rbx + addr], and the
+// instruction counter lives in r14.
+//
+// Blocks are chained: a block exit first returns to the dispatcher,
+// which translates the target and patches the exit into a direct jmp,
+// so hot loops run without leaving generated code. Every STORE checks a
+// 256-byte map of translated code bytes; a hit leaves the block and only
+// the blocks that read the written byte are dropped (and unchained), so
+// self-modifying code stays correct without retranslating the rest. Once
+// a byte has been changed, a LOAD/ADD/STORE that uses it as its operand is
+// translated to read the operand at run time.
+// STOREP and STOREX do the same check on the address they compute.
+// Results (memory, ACC, C, X, PC, IR, steps) match cpu_run().
+//
+// Needs only Linux + x86-64 (mmap with PROT_EXEC). On other targets
+// cpu_jit_new() returns NULL and cpu_jit_run() is cpu_run().
+
+#ifndef CPU_JIT_H
+#define CPU_JIT_H
+
+#include "cpu_core.h"
+
+typedef struct cpu_jit cpu_jit_t;
+
+cpu_jit_t *cpu_jit_new(void);          // NULL if no JIT on this host
+void       cpu_jit_free(cpu_jit_t *j);
+void       cpu_jit_flush(cpu_jit_t *j);  // drop every translated block
+
+// Same contract as cpu_run(): runs c from c->PC until HALT (0) or an
+// unknown opcode (-1). A cpu_jit_t may be reused across runs and images;
+// translations whose guest bytes changed since the last run are dropped.
+int cpu_jit_run(cpu_jit_t *j, cpu_t *c);
+
+#endif // CPU_JIT_H
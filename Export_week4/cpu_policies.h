@@ -0,0 +1,84 @@
+// cpu_policies.h
+// Una variante de cpu_exec.h por cada máscara de CPU_POLICY_*.
+//
+// NO es un header normal: cpu_core.c lo incluye dos veces. Sin más, genera
+// las funciones; con CPU_POLICIES_TABLE definido, los inicializadores
+// [máscara] = función de la tabla de cpu_engine().
+//
+// Se incluye a sí mismo una vez por bit de la máscara (CPU_POLICY_B3 ..
+// CPU_POLICY_B0, primero a 0 y luego a 1), así que cada una de las
+// 1 << CPU_POLICY_BITS máscaras sale exactamente una vez en las dos
+// pasadas. Todas usan el despacho del motor sin caché más rápido y se
+// llaman cpu_run_policy_<bits>, p. ej. cpu_run_policy_0101 para
+// CPU_POLICY_BOUNDS | CPU_POLICY_TRACE, salvo:
+//   0000  sin políticas: no se genera, la tabla apunta a cpu_run
+//   1000  sólo perfil: cpu_run_profile (declarada en cpu_core.h)
+
+#define CPU_POLICY_BITS 4
+
+#if !defined(CPU_POLICY_B3)
+#if !defined(CPU_POLICIES_TABLE)
+_Static_assert(CPU_POLICY_COUNT == 1 << CPU_POLICY_BITS,
+               "cpu_policies.h recorre CPU_POLICY_BITS bits");
+#endif
+#define CPU_POLICY_B3 0
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B3
+#define CPU_POLICY_B3 1
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B3
+
+#elif !defined(CPU_POLICY_B2)
+#define CPU_POLICY_B2 0
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B2
+#define CPU_POLICY_B2 1
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B2
+
+#elif !defined(CPU_POLICY_B1)
+#define CPU_POLICY_B1 0
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B1
+#define CPU_POLICY_B1 1
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B1
+
+#elif !defined(CPU_POLICY_B0)
+#define CPU_POLICY_B0 0
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B0
+#define CPU_POLICY_B0 1
+#include "cpu_policies.h"
+#undef  CPU_POLICY_B0
+
+#else
+// Una máscara: los cuatro bits están fijados
+#define CPU_POLICY_MASK \
+    (CPU_POLICY_B3 << 3 | CPU_POLICY_B2 << 2 | CPU_POLICY_B1 << 1 | CPU_POLICY_B0)
+#define CPU_POLICY_PASTE(b3, b2, b1, b0)    cpu_run_policy_##b3##b2##b1##b0
+#define CPU_POLICY_XPASTE(b3, b2, b1, b0)   CPU_POLICY_PASTE(b3, b2, b1, b0)
+
+#if CPU_POLICY_MASK == 0
+#define CPU_POLICY_FN   cpu_run
+#elif CPU_POLICY_MASK == CPU_POLICY_PROFILE
+#define CPU_POLICY_FN   cpu_run_profile
+#else
+#define CPU_POLICY_FN   \
+    CPU_POLICY_XPASTE(CPU_POLICY_B3, CPU_POLICY_B2, CPU_POLICY_B1, CPU_POLICY_B0)
+#endif
+
+#if defined(CPU_POLICIES_TABLE)
+    [CPU_POLICY_MASK] = CPU_POLICY_FN,
+#elif CPU_POLICY_MASK != 0
+#define CPU_EXEC_NAME      CPU_POLICY_FN
+#define CPU_EXEC_THREADED  CPU_HAVE_THREADED
+#define CPU_EXEC_POLICY    CPU_POLICY_MASK
+#include "cpu_exec.h"
+#endif
+
+#undef CPU_POLICY_FN
+#undef CPU_POLICY_XPASTE
+#undef CPU_POLICY_PASTE
+#undef CPU_POLICY_MASK
+#endif
@@ -0,0 +1,91 @@
+// cpu_profile.c
+// Profile report joined with the assembler listing (see cpu_profile.h).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cpu_profile.h"
+
+static const char *op_name(int op) {
+    const isa_insn_t *in = isa_find((uint8_t)op);
+    return in ? in->name : "?";
+}
+
+// Address at the start of a listing line ("00C4  ..."), or -1
+static int line_addr(const char *line) {
+    for (int i = 0; i < 4; i++)
+        if (!isxdigit((unsigned char)line[i])) return -1;
+    if (line[4] != ' ') return -1;
+    int addr;
+    if (sscanf(line, "%4x", &addr) != 1 || addr >= MEM_SIZE) return -1;
+    return addr;
+}
+
+int cpu_profile_report(FILE *out, const cpu_profile_t *p, const char *lst_path) {
+    FILE *f = fopen(lst_path, "r");
+    if (!f) {
+        perror(lst_path);
+        return -1;
+    }
+
+    uint64_t total = 0;
+    for (int a = 0; a < MEM_SIZE; a++) total += p->pc[a];
+    double scale = total ? 100.0 / (double)total : 0.0;
+
+    fprintf(out, "; PROFILE of %s: %llu instructions executed\n\n",
+            lst_path, (unsigned long long)total);
+
+    uint8_t listed[MEM_SIZE] = { 0 };
+    char line[1024];
+    while (fgets(line, sizeof line, f)) {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = 0;
+
+        int addr = line_addr(line);
+        if (addr < 0 && n == 0) {
+            fputc('\n', out);
+            continue;
+        }
+        if (addr < 0) {
+            // the column headers of the listing get headers of their own
+            const char *head = strncmp(line, "ADDR ", 5) == 0 ? "      HITS  %TOTAL"
+                             : strncmp(line, "==== ", 5) == 0 ? "      ====  ======"
+                             : "";
+            fprintf(out, "%-18s  %s\n", head, line);
+            continue;
+        }
+
+        listed[addr] = 1;
+        uint64_t hits = p->pc[addr];
+        if (hits)
+            fprintf(out, "%10llu %6.2f%%  %s", (unsigned long long)hits,
+                    (double)hits * scale, line);
+        else
+            fprintf(out, "%10s %7s  %s", "", "", line);
+        if (p->taken[addr] || p->not_taken[addr])
+            fprintf(out, "    ; taken %llu, not taken %llu",
+                    (unsigned long long)p->taken[addr],
+                    (unsigned long long)p->not_taken[addr]);
+        fputc('\n', out);
+    }
+    fclose(f);
+
+    fprintf(out, "\nOPCODES:\n");
+    for (int op = 0; op < 256; op++) {
+        if (!p->op[op]) continue;
+        fprintf(out, "  %-6s 0x%02X  %12llu  %6.2f%%\n", op_name(op), op,
+                (unsigned long long)p->op[op], (double)p->op[op] * scale);
+    }
+
+    int header = 0;
+    for (int a = 0; a < MEM_SIZE; a++) {
+        if (!p->pc[a] || listed[a]) continue;
+        if (!header) fprintf(out, "\nNOT IN LISTING:\n");
+        header = 1;
+        fprintf(out, "  PC 0x%02X  %12llu  %6.2f%%\n", a,
+                (unsigned long long)p->pc[a], (double)p->pc[a] * scale);
+    }
+    return 0;
+}
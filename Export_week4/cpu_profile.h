@@ -0,0 +1,26 @@
+// cpu_profile.h
+// Profile report: the counts gathered by cpu_run_profile() (cpu_core.h)
+// joined with the listing the assembler writes next to every image
+// (assembler_v2's .lst, "ADDR  BYTES  SOURCE" columns).
+//
+// Every listing line with an address gets two more columns in front: how
+// many times the instruction at that address ran and its share of all
+// the instructions executed; a conditional jump (JZ, JNZ, JC) also shows
+// how often it jumped.
+// Lines without an address (labels, directives, the header and symbol
+// table) are copied as they are. After the listing come the counts per
+// opcode and, if any, PCs that ran but start no listing line (a jump into
+// an operand byte, or code the program wrote itself).
+
+#ifndef CPU_PROFILE_H
+#define CPU_PROFILE_H
+
+#include <stdio.h>
+
+#include "cpu_core.h"
+
+// Writes the report for p and the listing lst_path to out. Returns 0, or
+// -1 (after perror) if the listing cannot be read.
+int cpu_profile_report(FILE *out, const cpu_profile_t *p, const char *lst_path);
+
+#endif // CPU_PROFILE_H
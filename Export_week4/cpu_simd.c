@@ -0,0 +1,433 @@
+// cpu_simd.c
+// Lane-parallel interpreter (see cpu_simd.h).
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu_simd.h"
+
+// A set of lanes that currently share the same PC.
+typedef struct {
+    uint8_t pc;
+    cpu_lanes_t mask;      // 0xFF for lanes in the group
+} group_t;
+
+// ---------------------------------------------------------------------
+// Vector helpers
+// ---------------------------------------------------------------------
+static inline int lanes_any(cpu_lanes_t v) {
+    uint64_t w[CPU_SIMD_LANES / 8];
+    uint64_t r = 0;
+    memcpy(w, &v, sizeof w);
+    for (int i = 0; i < CPU_SIMD_LANES / 8; i++) r |= w[i];
+    return r != 0;
+}
+
+static inline int lanes_equal(cpu_lanes_t a, cpu_lanes_t b) {
+    return !lanes_any(a ^ b);
+}
+
+static inline cpu_lanes_t lanes_splat(uint8_t v) {
+    cpu_lanes_t r;
+    for (int i = 0; i < CPU_SIMD_LANES; i++) r[i] = v;
+    return r;
+}
+
+// mask ? a : b, lane by lane
+static inline cpu_lanes_t lanes_blend(cpu_lanes_t mask, cpu_lanes_t a, cpu_lanes_t b) {
+    return (a & mask) | (b & ~mask);
+}
+
+// 1 where a < b (unsigned), else 0
+static inline cpu_lanes_t lanes_below(cpu_lanes_t a, cpu_lanes_t b) {
+    return (cpu_lanes_t)(a < b) & lanes_splat(1);
+}
+
+// a + b + cin and its carry out, lane by lane (cin is 0 or 1)
+static inline cpu_lanes_t lanes_add(cpu_lanes_t a, cpu_lanes_t b, cpu_lanes_t cin,
+                                    cpu_lanes_t *cout) {
+    cpu_lanes_t s = a + b, r = s + cin;
+    *cout = lanes_below(s, a) | lanes_below(r, s);
+    return r;
+}
+
+// a - b - bin and its borrow, lane by lane (bin is 0 or 1)
+static inline cpu_lanes_t lanes_sub(cpu_lanes_t a, cpu_lanes_t b, cpu_lanes_t bin,
+                                    cpu_lanes_t *bout) {
+    cpu_lanes_t d = a - b;
+    *bout = lanes_below(a, b) | lanes_below(d, bin);
+    return d - bin;
+}
+
+// Address of the data byte of LOADP/ADDP/STOREP (the pointer at addr)
+// or LOADX/ADDX/STOREX (addr + X), which may differ from lane to lane
+static inline cpu_lanes_t lanes_data_addr(const cpu_simd_t *s, uint8_t op, uint8_t addr,
+                                          cpu_lanes_t x) {
+    return isa_kind(op) == ISA_PTR ? s->mem[addr] : lanes_splat(addr) + x;
+}
+
+// mem[addrs[lane]][lane] for every lane
+static inline cpu_lanes_t lanes_gather(const cpu_simd_t *s, cpu_lanes_t addrs) {
+    cpu_lanes_t r;
+    for (int l = 0; l < CPU_SIMD_LANES; l++) r[l] = s->mem[addrs[l]][l];
+    return r;
+}
+
+// mem[addrs[lane]][lane] = v[lane] for the lanes of mask
+static inline void lanes_scatter(cpu_simd_t *s, cpu_lanes_t mask, cpu_lanes_t addrs,
+                                 cpu_lanes_t v) {
+    for (int l = 0; l < CPU_SIMD_LANES; l++) {
+        if (mask[l]) {
+            s->mem[addrs[l]][l] = v[l];
+            s->uniform[addrs[l]] = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------
+void cpu_simd_load(cpu_simd_t *s, const uint8_t img[MEM_SIZE]) {
+    for (int a = 0; a < MEM_SIZE; a++) {
+        s->mem[a] = lanes_splat(img[a]);
+        s->uniform[a] = 1;
+    }
+    s->acc = lanes_splat(0);
+    s->carry = lanes_splat(0);
+    s->x = lanes_splat(0);
+    memset(s->pc, 0, sizeof s->pc);
+    memset(s->status, 0, sizeof s->status);
+    s->start_pc = 0;
+}
+
+void cpu_simd_poke(cpu_simd_t *s, int lane, uint8_t addr, uint8_t value) {
+    s->mem[addr][lane] = value;
+    s->uniform[addr] = 0;
+}
+
+uint8_t cpu_simd_peek(const cpu_simd_t *s, int lane, uint8_t addr) {
+    return s->mem[addr][lane];
+}
+
+// ---------------------------------------------------------------------
+// Scalar fallback for one lane
+//
+// Used when the lanes of a group disagree on a code byte (self-modifying
+// code with lane-dependent data). The lane is moved out of the vector
+// state, finished with cpu_run() starting at `pc`, and written back.
+// ---------------------------------------------------------------------
+static void run_lane_scalar(cpu_simd_t *s, int lane, uint8_t pc) {
+    cpu_t c;
+    cpu_init(&c);
+    for (int a = 0; a < MEM_SIZE; a++) c.mem[a] = s->mem[a][lane];
+    c.ACC = s->acc[lane];
+    c.C   = s->carry[lane];
+    c.X   = s->x[lane];
+    c.PC  = pc;
+
+    s->status[lane] = (int8_t)cpu_run(&c);
+    s->pc[lane] = c.PC;
+    s->acc[lane] = c.ACC;
+    s->carry[lane] = c.C;
+    s->x[lane] = c.X;
+
+    for (int a = 0; a < MEM_SIZE; a++) {
+        if (s->mem[a][lane] != c.mem[a]) {
+            s->mem[a][lane] = c.mem[a];
+            s->uniform[a] = 0;
+        }
+    }
+}
+
+// Slow path of FETCH for bytes that are not known to be uniform. Lanes of
+// the group that hold a different byte than its first lane are finished in
+// scalar mode from `pc` and dropped from the returned mask. ACC, C and X
+// are passed through s->acc, s->carry and s->x so the fast path can keep
+// them in registers.
+typedef struct {
+    cpu_lanes_t mask;
+    uint8_t value;
+} fetched_t;
+
+static fetched_t fetch_divergent(cpu_simd_t *s, cpu_lanes_t mask,
+                                 uint8_t pc, uint8_t addr) {
+    int first = 0;
+    while (!mask[first]) first++;
+    uint8_t v = s->mem[addr][first];
+
+    cpu_lanes_t differ = (cpu_lanes_t)(s->mem[addr] != lanes_splat(v)) & mask;
+    if (lanes_any(differ)) {
+        for (int l = 0; l < CPU_SIMD_LANES; l++) {
+            if (differ[l]) run_lane_scalar(s, l, pc);
+        }
+        mask &= ~differ;
+    }
+    return (fetched_t){ mask, v };
+}
+
+// Read the code byte at addr for the group (pc, m) into out. If every
+// lane of the group was moved to the scalar fallback, the group is done.
+#define FETCH(addr, out)                                          \
+    do {                                                          \
+        if (s->uniform[addr]) {                                   \
+            (out) = s->mem[addr][0];                              \
+        } else {                                                  \
+            s->acc = acc;                                         \
+            s->carry = carry;                                     \
+            s->x = x;                                             \
+            fetched_t f_ = fetch_divergent(s, m, pc, (addr));     \
+            acc = s->acc;                                         \
+            carry = s->carry;                                     \
+            x = s->x;                                             \
+            m = f_.mask;                                          \
+            (out) = f_.value;                                     \
+            if (!lanes_any(m)) goto group_done;                   \
+        }                                                         \
+    } while (0)
+
+// ---------------------------------------------------------------------
+// Main loop
+// ---------------------------------------------------------------------
+int cpu_simd_run(cpu_simd_t *s, int nlanes) {
+    group_t groups[CPU_SIMD_LANES];
+    int ngroups = 0;
+    int rc = 0;
+    cpu_lanes_t acc = s->acc, carry = s->carry, x = s->x;
+    cpu_lanes_t zero = lanes_splat(0), res, cout, ea;
+
+    if (nlanes > CPU_SIMD_LANES) nlanes = CPU_SIMD_LANES;
+    if (nlanes <= 0) return 0;
+
+    cpu_lanes_t live = lanes_splat(0);
+    for (int l = 0; l < nlanes; l++) {
+        live[l] = 0xFF;
+        s->pc[l] = s->start_pc;
+        s->status[l] = 0;
+    }
+    groups[ngroups++] = (group_t){ s->start_pc, live };
+
+    while (ngroups > 0) {
+        // Pick the group with the lowest PC and merge every group at that PC
+        int cur = 0;
+        for (int i = 1; i < ngroups; i++)
+            if (groups[i].pc < groups[cur].pc) cur = i;
+
+        uint8_t pc = groups[cur].pc;
+        cpu_lanes_t m = lanes_splat(0);
+        unsigned next = MEM_SIZE;       // lowest PC of any other group
+        int k = 0;
+        for (int i = 0; i < ngroups; i++) {
+            if (groups[i].pc == pc) {
+                m |= groups[i].mask;
+            } else {
+                if (groups[i].pc < next) next = groups[i].pc;
+                groups[k++] = groups[i];
+            }
+        }
+        ngroups = k;
+
+        // Run the group straight-line until it branches, halts, or
+        // reaches the PC of another group (then they merge)
+        for (;;) {
+            if (pc == next) {
+                groups[ngroups++] = (group_t){ pc, m };
+                break;
+            }
+
+            uint8_t op, addr = 0;
+            FETCH(pc, op);
+            if (cpu_insn_len(op) == 2) {
+                FETCH((uint8_t)(pc + 1), addr);
+            }
+
+            switch (op) {
+
+                case NOP:
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case LOAD:
+                    acc = lanes_blend(m, s->mem[addr], acc);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                // Additions and subtractions compute the result and the
+                // carry of every lane, then keep those of the group
+                case ADD:
+                    res = lanes_add(acc, s->mem[addr], zero, &cout);  // 8-bit wrap in every lane
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case ADC:
+                    res = lanes_add(acc, s->mem[addr], carry, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case MUL:
+                    acc = lanes_blend(m, acc * s->mem[addr], acc);  // low byte in every lane
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case SUB:
+                    res = lanes_sub(acc, s->mem[addr], zero, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case SBC:
+                    res = lanes_sub(acc, s->mem[addr], carry, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case LOADI:
+                    acc = lanes_blend(m, lanes_splat(addr), acc);   // addr is the immediate
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case ADDI:
+                    res = lanes_add(acc, lanes_splat(addr), zero, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case SUBI:
+                    res = lanes_sub(acc, lanes_splat(addr), zero, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case STORE:
+                    s->mem[addr] = lanes_blend(m, acc, s->mem[addr]);
+                    s->uniform[addr] = 0;
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                // Through a pointer or X every lane may address a
+                // different byte: gather / scatter lane by lane
+                case LOADP:
+                case LOADX:
+                    ea = lanes_data_addr(s, op, addr, x);
+                    acc = lanes_blend(m, lanes_gather(s, ea), acc);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case ADDP:
+                case ADDX:
+                    ea = lanes_data_addr(s, op, addr, x);
+                    res = lanes_add(acc, lanes_gather(s, ea), zero, &cout);
+                    acc = lanes_blend(m, res, acc);
+                    carry = lanes_blend(m, cout, carry);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case STOREP:
+                case STOREX:
+                    ea = lanes_data_addr(s, op, addr, x);
+                    lanes_scatter(s, m, ea, acc);
+                    pc = (uint8_t)(pc + 2);
+                    continue;
+
+                case INX:
+                    x = lanes_blend(m, x + lanes_splat(1), x);
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case DEX:
+                    x = lanes_blend(m, x - lanes_splat(1), x);
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case TAX:
+                    x = lanes_blend(m, acc, x);
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case TXA:
+                    acc = lanes_blend(m, x, acc);
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case JMP:
+                    groups[ngroups++] = (group_t){ addr, m };
+                    break;
+
+                case JZ: {
+                    cpu_lanes_t z = (cpu_lanes_t)(acc == lanes_splat(0)) & m;
+                    if (!lanes_any(z)) {
+                        pc = (uint8_t)(pc + 2);
+                        continue;
+                    }
+                    if (lanes_equal(z, m)) {
+                        groups[ngroups++] = (group_t){ addr, m };
+                    } else {
+                        // Divergence: split the group in two
+                        groups[ngroups++] = (group_t){ addr, z };
+                        groups[ngroups++] = (group_t){ (uint8_t)(pc + 2), m & ~z };
+                    }
+                } break;
+
+                case JNZ:
+                case JC: {
+                    cpu_lanes_t t = (cpu_lanes_t)((op == JC ? carry : acc) != zero) & m;
+                    if (!lanes_any(t)) {
+                        pc = (uint8_t)(pc + 2);
+                        continue;
+                    }
+                    if (lanes_equal(t, m)) {
+                        groups[ngroups++] = (group_t){ addr, m };
+                    } else {
+                        groups[ngroups++] = (group_t){ addr, t };
+                        groups[ngroups++] = (group_t){ (uint8_t)(pc + 2), m & ~t };
+                    }
+                } break;
+
+                case PRINT:
+                    for (int l = 0; l < CPU_SIMD_LANES; l++) {
+                        if (m[l]) {
+                            printf("[CPU] ACC=%3u (0x%02X), PC=0x%02X\n",
+                                   acc[l], acc[l], (uint8_t)(pc + 1));
+                        }
+                    }
+                    pc = (uint8_t)(pc + 1);
+                    continue;
+
+                case HALT:
+                    for (int l = 0; l < CPU_SIMD_LANES; l++) {
+                        if (m[l]) {
+                            s->pc[l] = (uint8_t)(pc + 1);
+                            s->status[l] = 0;
+                        }
+                    }
+                    break;
+
+                default:
+                    for (int l = 0; l < CPU_SIMD_LANES; l++) {
+                        if (m[l]) {
+                            printf("Unknown opcode 0x%02X at PC=0x%02X\n", op, pc);
+                            s->pc[l] = (uint8_t)(pc + 1);
+                            s->status[l] = -1;
+                        }
+                    }
+                    break;
+            }
+            break;
+        }
+group_done:;
+    }
+
+    s->acc = acc;
+    s->carry = carry;
+    s->x = x;
+    for (int l = 0; l < nlanes; l++)
+        if (s->status[l] != 0) rc = -1;
+    return rc;
+}
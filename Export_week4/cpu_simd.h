@@ -0,0 +1,63 @@
+// cpu_simd.h
+// Lane-parallel interpreter: runs CPU_SIMD_LANES copies of the same
+// 256-byte image, each with its own ACC, C, X, PC and memory, as the lanes
+// of one host vector.
+//
+// Memory is stored transposed (mem[addr] is a vector holding that byte
+// for every lane), so LOAD/ADD/STORE are one vector operation for all
+// lanes; LOADP/LOADX and their kin, whose address may differ per lane,
+// gather and scatter lane by lane. Lanes that share a PC form a group
+// and execute together under a mask. When a conditional jump splits a
+// group, the group with the lowest PC runs first and groups are merged
+// again as soon as their PCs meet, so loops with different trip counts
+// reconverge at the loop exit.
+//
+// Per-lane results are identical to cpu_run() (cpu_core.c). The only
+// observable difference is the interleaving of PRINT output between lanes.
+//
+// The lane count follows the widest byte vector the target has: 64 with
+// -mavx512bw, 32 with -mavx2, 16 otherwise (SSE2). -DCPU_SIMD_LANES=N
+// overrides it (N must be a multiple of 8).
+
+#ifndef CPU_SIMD_H
+#define CPU_SIMD_H
+
+#include <stdint.h>
+
+#include "cpu_core.h"
+
+#ifndef CPU_SIMD_LANES
+#if defined(__AVX512BW__)
+#define CPU_SIMD_LANES 64
+#elif defined(__AVX2__)
+#define CPU_SIMD_LANES 32
+#else
+#define CPU_SIMD_LANES 16
+#endif
+#endif
+
+typedef uint8_t cpu_lanes_t __attribute__((vector_size(CPU_SIMD_LANES)));
+
+typedef struct {
+    cpu_lanes_t mem[MEM_SIZE];             // mem[addr][lane]
+    cpu_lanes_t acc;                       // ACC of every lane
+    cpu_lanes_t carry;                     // C of every lane (0 or 1)
+    cpu_lanes_t x;                         // X of every lane
+    uint8_t pc[CPU_SIMD_LANES];            // PC of every lane after the run
+    int8_t  status[CPU_SIMD_LANES];        // 0 = HALT, -1 = unknown opcode
+    uint8_t uniform[MEM_SIZE];             // 1 if every lane holds the same byte
+    uint8_t start_pc;                      // PC where every lane starts
+} cpu_simd_t;
+
+// Same image in every lane, ACC = C = X = 0, start_pc = 0.
+void cpu_simd_load(cpu_simd_t *s, const uint8_t img[MEM_SIZE]);
+
+// Per-lane access to memory (e.g. a different N at 0xC0 in each lane).
+void    cpu_simd_poke(cpu_simd_t *s, int lane, uint8_t addr, uint8_t value);
+uint8_t cpu_simd_peek(const cpu_simd_t *s, int lane, uint8_t addr);
+
+// Runs lanes [0, nlanes) until every one halts. Returns 0 if all of them
+// reached HALT, -1 if any stopped on an unknown opcode.
+int cpu_simd_run(cpu_simd_t *s, int nlanes);
+
+#endif // CPU_SIMD_H
@@ -0,0 +1,131 @@
+; factorial32.asm — N! en 32 bits con acarreo (ADD/ADC, JC)
+; ISA: LOAD=0x01, ADD=0x02, STORE=0x03, JMP=0x04, JZ=0x05, JNZ=0x09,
+;      LOADI=0x0A, SUBI=0x0C, ADC=0x0D, JC=0x0F, HALT=0xFF
+;
+; Contrato con C (main2link_loadmem.c --wide):
+;   - C debe escribir N en la dirección 0xC0
+;   - Al terminar, RESULT (0xC1..0xC4, little endian) contiene N! (mod 2^32)
+;     (exacto hasta 12! = 479001600)
+;
+; Esquema:
+;   RESULT = 1
+;   for COUNTER = N .. 1:
+;       RESULT = RESULT * COUNTER       ; 32 x 8 bits
+;
+; MUL sólo da el byte bajo, así que el producto se hace por desplazamiento
+; y suma, del bit alto de COUNTER al bajo (Horner):
+;   P = 0
+;   8 veces: P = 2*P; K = 2*K (el bit que sale queda en C); si C: P += RESULT
+; Cada desplazamiento o suma de 32 bits es ADD en el byte bajo y ADC en los
+; otros tres: 3 instrucciones por byte.
+
+        ; exportados para el linker; cada byte del resultado, para que -O no
+        ; tome R1..R3 por variables internas
+        .global FACTORIAL32, N, RESULT, R1, R2, R3
+
+        .org 0x00
+
+        ; RESULT = 1
+FACTORIAL32:
+        LOAD  #1
+        STORE R0
+        LOAD  #0
+        STORE R1
+        STORE R2
+        STORE R3
+
+        ; if N == 0 goto END (0! = 1)
+        LOAD  N
+        JZ    END
+        STORE COUNTER
+
+OUTER:
+        ; P = 0, K = COUNTER, 8 bits por recorrer
+        LOAD  COUNTER
+        STORE K
+        LOAD  #0
+        STORE P0
+        STORE P1
+        STORE P2
+        STORE P3
+        LOAD  #8
+        STORE BITS
+
+BIT:
+        ; P = 2*P
+        LOAD  P0
+        ADD   P0
+        STORE P0
+        LOAD  P1
+        ADC   P1
+        STORE P1
+        LOAD  P2
+        ADC   P2
+        STORE P2
+        LOAD  P3
+        ADC   P3
+        STORE P3
+
+        ; K = 2*K: su bit 7 pasa a C
+        LOAD  K
+        ADD   K
+        STORE K
+        JC    ADDR
+        JMP   NEXTBIT
+
+        ; P = P + RESULT (el bit de K era 1)
+ADDR:
+        LOAD  P0
+        ADD   R0
+        STORE P0
+        LOAD  P1
+        ADC   R1
+        STORE P1
+        LOAD  P2
+        ADC   R2
+        STORE P2
+        LOAD  P3
+        ADC   R3
+        STORE P3
+
+NEXTBIT:
+        LOAD  BITS
+        SUB   #1
+        STORE BITS
+        JNZ   BIT
+
+        ; RESULT = P
+        LOAD  P0
+        STORE R0
+        LOAD  P1
+        STORE R1
+        LOAD  P2
+        STORE R2
+        LOAD  P3
+        STORE R3
+
+        ; COUNTER - 1; repeat mientras no sea 0
+        LOAD  COUNTER
+        SUB   #1
+        STORE COUNTER
+        JNZ   OUTER
+
+END:
+        LOAD  R0       ; ACC = byte bajo de N!
+        HALT
+
+; ---------------- DATA ----------------
+        .org 0xC0
+N:      .byte 0      ; <- C pone aquí el valor de N (dinámico)
+RESULT:
+R0:     .byte 0      ; N! byte 0 (bajo)
+R1:     .byte 0
+R2:     .byte 0
+R3:     .byte 0      ; N! byte 3 (alto)
+COUNTER:.byte 0
+K:      .byte 0      ; COUNTER, desplazándose a la izquierda
+BITS:   .byte 0
+P0:     .byte 0      ; producto parcial, 32 bits
+P1:     .byte 0
+P2:     .byte 0
+P3:     .byte 0
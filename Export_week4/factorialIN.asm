@@ -1,5 +1,6 @@
-; factorial.asm — cálculo general de N! usando bucles
-; ISA: LOAD=0x01, ADD=0x02, STORE=0x03, JMP=0x04, JZ=0x05, HALT=0xFF
+; factorial.asm — cálculo general de N! con MUL e inmediatos
+; ISA: LOAD=0x01, STORE=0x03, JZ=0x05, MUL=0x07, JNZ=0x09, LOADI=0x0A,
+;      SUBI=0x0C, HALT=0xFF   ("LOAD #1" = LOADI 1, "SUB #1" = SUBI 1)
 ;
 ; Contrato con C (main2link.c):
 ;   - C debe escribir N en la dirección 0xC0
@@ -9,67 +10,39 @@
 ;   RESULT = 1
 ;   COUNTER = N
 ;   while COUNTER != 0:
-;       PART = 0
-;       TEMP = COUNTER
-;       while TEMP != 0:
-;           PART += RESULT
-;           TEMP -= 1
-;       RESULT = PART
+;       RESULT = RESULT * COUNTER
 ;       COUNTER -= 1
+;
+; Las constantes van en el propio operando (#1): sin ONE/NEG1 en memoria
+; ni una carga por cada una. El test del bucle va al final (JNZ), así que
+; cada vuelta son 6 instrucciones y ningún JMP.
+
+        ; Exportados para el linker (main2link.obj)
+        .global FACTORIAL, N, RESULT
 
         .org 0x00
 
         ; RESULT = 1
-        LOAD  ONE
+FACTORIAL:
+        LOAD  #1
         STORE RESULT
 
-        ; COUNTER = N
+        ; if N == 0 goto END (0! = 1)
         LOAD  N
-        STORE COUNTER
-
-LOOP:
-        ; if COUNTER == 0 goto END
-        LOAD  COUNTER
         JZ    END
 
-        ; PART = 0
-        LOAD  ZERO
-        STORE PART
-
-        ; TEMP = COUNTER
-        LOAD  COUNTER
-        STORE TEMP
-
-INNER:
-        ; PART = PART + RESULT
-        LOAD  PART
-        ADD   RESULT
-        STORE PART
-
-        ; TEMP = TEMP - 1 (NEG1 = 0xFF)
-        LOAD  TEMP
-        ADD   NEG1
-        STORE TEMP
-
-        ; if TEMP == 0 goto INNER_END
-        LOAD  TEMP
-        JZ    INNER_END
-
-        ; else goto INNER
-        JMP   INNER
+LOOP:
+        ; COUNTER = ACC (N la primera vez, luego COUNTER - 1)
+        STORE COUNTER
 
-INNER_END:
-        ; RESULT = PART
-        LOAD  PART
+        ; RESULT = RESULT * COUNTER
+        MUL   RESULT
         STORE RESULT
 
-        ; COUNTER = COUNTER - 1
+        ; COUNTER - 1; repeat loop mientras no sea 0
         LOAD  COUNTER
-        ADD   NEG1
-        STORE COUNTER
-
-        ; repeat outer loop
-        JMP   LOOP
+        SUB   #1
+        JNZ   LOOP
 
 ; Al terminar: factorial queda en RESULT (y lo copiamos a ACC)
 END:
@@ -81,9 +54,3 @@ END:
 N:      .byte 0      ; <- C pone aquí el valor de N (dinámico)
 RESULT: .byte 0
 COUNTER:.byte 0
-TEMP:   .byte 0
-PART:   .byte 0
-ONE:    .byte 1
-ZERO:   .byte 0
-NEG1:   .byte 255    ; 0xFF = -1 en aritmética de 8 bits
-
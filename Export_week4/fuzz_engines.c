@@ -0,0 +1,335 @@
+// fuzz_engines.c
+// Differential check of every execution engine and of the assembler's -O
+// on random programs.
+//
+// Usage: ./fuzz_engines.x [programs] [seed]      (default 100000 1)
+//
+// Engines: random images (every opcode but PRINT, operands mostly in a
+// small data window, so pointers and STOREs often land on code) run
+// first on ref_run(), a plain switch written from the table in isa.h
+// with a step limit. Each one that halts is then run on cpu_run(), the 16
+// cpu_engine() variants, cpu_run_predecoded() and the JIT. One cpu_jit_t
+// serves every program and is only flushed now and then, so stale and
+// partly invalidated translations are exercised too. ACC, C, X, PC,
+// steps and all of memory must match the model.
+//
+// -O: random sources (LOAD/STORE/ADD/MUL/SUB/ADC/SBC, immediates, LOADX
+// and STOREX inside the data, jumps to random labels, with or without
+// .global) are assembled with and without the optimizer and both images
+// run on ref_run(). ACC, C and the data a caller can see must match, and
+// -O must not execute more instructions. A module with .global is called
+// twice keeping its memory, as --linked does, so a STORE that only the
+// next call reads has to stay. Some of them also export one of D0..D3
+// through a .global .equ alias, which makes that slot visible as well.
+//
+// Prints how many programs of each kind were checked. The first mismatch
+// is printed with its image or source, and the exit status is 1.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cpu_core.h"
+#include "cpu_jit.h"
+#include "../Export_week2/asm_lib.h"
+
+#define STEP_LIMIT 5000
+#define DATA       0x80     // random images: data window DATA..DATA+7
+
+typedef struct {
+    uint8_t  acc, c, x, pc;
+    uint64_t steps;
+    int      wrapped;       // execution ran past 0xFF (CPU_POLICY_BOUNDS stops)
+} ref_state_t;
+
+// The ISA as isa.h describes it, without caches or fusion. Runs a copy of
+// img in mem from PC 0. Returns 1 on HALT, 0 if it did not halt within
+// limit steps, -1 on an unknown opcode.
+static int ref_run(const uint8_t img[MEM_SIZE], uint8_t mem[MEM_SIZE],
+                   ref_state_t *s, int limit) {
+    memset(s, 0, sizeof *s);
+    memcpy(mem, img, MEM_SIZE);
+    for (int n = 0; n < limit; n++) {
+        uint8_t op = mem[s->pc], a = mem[(uint8_t)(s->pc + 1)];
+        uint8_t ea = isa_kind(op) == ISA_PTR ? mem[a] : (uint8_t)(a + s->x);
+        unsigned next = s->pc + (unsigned)cpu_insn_len(op), t;
+        int d;
+
+        if (!isa_find(op) || op == PRINT) return -1;
+        if (next > 0xFF) s->wrapped = 1;
+        s->steps++;
+        switch (op) {
+        case LOAD:   s->acc = mem[a]; break;
+        case ADD:    t = s->acc + mem[a]; s->acc = (uint8_t)t; s->c = t > 0xFF; break;
+        case STORE:  mem[a] = s->acc; break;
+        case MUL:    s->acc = (uint8_t)(s->acc * mem[a]); break;
+        case SUB:    s->c = s->acc < mem[a]; s->acc = (uint8_t)(s->acc - mem[a]); break;
+        case LOADI:  s->acc = a; break;
+        case ADDI:   t = s->acc + a; s->acc = (uint8_t)t; s->c = t > 0xFF; break;
+        case SUBI:   s->c = s->acc < a; s->acc = (uint8_t)(s->acc - a); break;
+        case ADC:    t = s->acc + mem[a] + s->c; s->acc = (uint8_t)t; s->c = t > 0xFF; break;
+        case SBC:    d = s->acc - mem[a] - s->c; s->acc = (uint8_t)d; s->c = d < 0; break;
+        case LOADP:
+        case LOADX:  s->acc = mem[ea]; break;
+        case ADDP:
+        case ADDX:   t = s->acc + mem[ea]; s->acc = (uint8_t)t; s->c = t > 0xFF; break;
+        case STOREP:
+        case STOREX: mem[ea] = s->acc; break;
+        case INX:    s->x++; break;
+        case DEX:    s->x--; break;
+        case TAX:    s->x = s->acc; break;
+        case TXA:    s->acc = s->x; break;
+        case JMP:    next = a; break;
+        case JZ:     if (s->acc == 0) next = a; break;
+        case JNZ:    if (s->acc != 0) next = a; break;
+        case JC:     if (s->c) next = a; break;
+        }
+        s->pc = (uint8_t)next;
+        if (op == HALT) return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// Engines
+// ---------------------------------------------------------------------
+static void random_image(uint8_t img[MEM_SIZE]) {
+    static const uint8_t ops[] = {
+        NOP, LOAD, ADD, STORE, JMP, JZ, MUL, SUB, JNZ, LOADI, ADDI, SUBI,
+        ADC, SBC, JC, LOADP, ADDP, STOREP, LOADX, ADDX, STOREX,
+        INX, DEX, TAX, TXA, STORE, STOREP, STOREX, HALT,
+    };
+    int n = 8 + 2 * (rand() % 20);
+
+    for (int a = 0; a < MEM_SIZE; a++)
+        img[a] = (uint8_t)(rand() % 4 ? DATA + rand() % 8 : rand());
+    // every instruction in a 2-byte cell, so jumps to even cells hit one
+    for (int i = 0; i < n; i += 2) {
+        uint8_t op = ops[rand() % (int)sizeof ops];
+        img[i] = op;
+        if (isa_kind(op) == ISA_JUMP)
+            img[i + 1] = (uint8_t)(rand() % (n / 2 + 1) * 2);
+        else if (isa_kind(op) == ISA_IMM)
+            img[i + 1] = (uint8_t)rand();
+        else if (cpu_insn_len(op) == 1)
+            img[i + 1] = NOP;
+        else
+            img[i + 1] = (uint8_t)(DATA + rand() % 8);
+    }
+    img[n] = HALT;
+}
+
+static void print_image(const uint8_t img[MEM_SIZE]) {
+    for (int a = 0; a < MEM_SIZE; a++)
+        printf("%02X%c", img[a], a % 16 == 15 ? '\n' : ' ');
+}
+
+// Engine e: 0..15 cpu_engine(e), 16 cpu_run_predecoded, 17 the JIT
+#define NENGINES (CPU_POLICY_COUNT + 2)
+
+static const char *engine_name(int e) {
+    static char name[32];
+    if (e == CPU_POLICY_COUNT) return "predecoded";
+    if (e == CPU_POLICY_COUNT + 1) return "jit";
+    snprintf(name, sizeof name, "cpu_engine(0x%X)", (unsigned)e);
+    return name;
+}
+
+static int fuzz_engines(long programs, long *checked, long *smc) {
+    static cpu_t c;
+    static cpu_profile_t prof;
+    cpu_jit_t *jit = cpu_jit_new();
+    int devnull = open("/dev/null", O_WRONLY), out = dup(1);
+
+    cpu_init(&c);
+    c.profile = &prof;
+    for (long it = 0; it < programs; it++) {
+        uint8_t img[MEM_SIZE], ref[MEM_SIZE];
+        ref_state_t s;
+
+        random_image(img);
+        if (ref_run(img, ref, &s, STEP_LIMIT) != 1) continue;
+        (*checked)++;
+        for (int a = 0; a < DATA; a++) {
+            if (ref[a] != img[a]) {
+                (*smc)++;
+                break;
+            }
+        }
+
+        for (int e = 0; e < NENGINES; e++) {
+            if (e < CPU_POLICY_COUNT && (e & CPU_POLICY_BOUNDS) && s.wrapped) continue;
+            // cpu_load only invalidates what changed: alternate with a
+            // full flush so both paths of the decode cache are used
+            cpu_load(&c, img);
+            cpu_reset(&c);
+            if (it & 1) cpu_flush(&c);
+            if (e == CPU_POLICY_COUNT + 1 && it % 7 == 0) cpu_jit_flush(jit);
+
+            int st;
+            if (e < CPU_POLICY_COUNT && (e & CPU_POLICY_TRACE)) {
+                fflush(stdout);
+                dup2(devnull, 1);
+                st = cpu_engine((unsigned)e)(&c);
+                fflush(stdout);
+                dup2(out, 1);
+            } else if (e < CPU_POLICY_COUNT) {
+                st = cpu_engine((unsigned)e)(&c);
+#if CPU_HAVE_THREADED
+            } else if (e == CPU_POLICY_COUNT) {
+                st = cpu_run_predecoded(&c);
+#endif
+            } else if (e == CPU_POLICY_COUNT + 1) {
+                st = cpu_jit_run(jit, &c);
+            } else {
+                continue;
+            }
+
+            if (st != CPU_HALTED || c.ACC != s.acc || c.C != s.c || c.X != s.x ||
+                c.PC != s.pc || c.steps != s.steps || memcmp(c.mem, ref, MEM_SIZE) != 0) {
+                printf("%s: status %d ACC=%02X C=%u X=%02X PC=%02X steps=%llu, "
+                       "expected ACC=%02X C=%u X=%02X PC=%02X steps=%llu\n",
+                       engine_name(e), st, c.ACC, c.C, c.X, c.PC, (unsigned long long)c.steps,
+                       s.acc, s.c, s.x, s.pc, (unsigned long long)s.steps);
+                print_image(img);
+                cpu_jit_free(jit);
+                return 1;
+            }
+        }
+    }
+    cpu_jit_free(jit);
+    close(devnull);
+    close(out);
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// -O
+// ---------------------------------------------------------------------
+static const char *const slots[] = { "D0", "D1", "D2", "D3", "OUT1", "OUT2" };
+#define NSLOTS      6
+#define SLOT_ADDR   0x80    // .org of the data: D0 .. OUT2
+
+// Appends one random line; X stays in 0..NSLOTS-1 (only "LOADI k; TAX"
+// sets it), so LOADX/STOREX D0,X never leave the data
+static int random_line(char *p, int ninsns) {
+    const char *v = slots[rand() % NSLOTS];
+    int t = rand() % (ninsns + 1);
+
+    switch (rand() % 19) {
+    case 0: case 1: case 2: return sprintf(p, "    LOAD  %s\n", v);
+    case 3: case 4:         return sprintf(p, "    STORE %s\n", v);
+    case 5:                 return sprintf(p, rand() % 2 ? "    ADD   %s\n" : "    MUL   %s\n", v);
+    case 6:                 return sprintf(p, "    SUB   %s\n", v);
+    case 7:                 return sprintf(p, rand() % 2 ? "    ADC   %s\n" : "    SBC   %s\n", v);
+    case 8:                 return sprintf(p, rand() % 2 ? "    LOAD  #%d\n" : "    LOADI %d\n", rand() % 3);
+    case 9:                 return sprintf(p, rand() % 2 ? "    ADD   #%d\n" : "    SUB   #%d\n", rand() % 3);
+    case 10:                return sprintf(p, "    JMP   T%d\n", t);
+    case 11: case 12:       return sprintf(p, "    JZ    T%d\n", t);
+    case 13:                return sprintf(p, "    JNZ   T%d\n", t);
+    case 14:                return sprintf(p, "    JC    T%d\n", t);
+    case 15:                return sprintf(p, "    LOADI %d\n    TAX\n", rand() % NSLOTS);
+    case 16:                return sprintf(p, "    LOADX D0,X\n");
+    case 17:                return sprintf(p, "    STOREX D0,X\n");
+    default:                return sprintf(p, "    HALT\n");
+    }
+}
+
+// Label T<i> before instruction i, so jumps land anywhere in the code.
+// alias: D<alias> is also exported as OUT3 (.equ), -1 = none
+static int random_source(char *src, int global, int alias) {
+    int ninsns = 5 + rand() % 25, n = 0;
+
+    if (global && alias >= 0)
+        n += sprintf(src + n, "    .global OUT1, OUT2, OUT3\n    .equ OUT3 0x%02X\n",
+                     SLOT_ADDR + alias);
+    else if (global)
+        n += sprintf(src + n, "    .global OUT1, OUT2\n");
+    n += sprintf(src + n, "    .org 0x00\n");
+    for (int i = 0; i < ninsns; i++) {
+        n += sprintf(src + n, "T%d:\n", i);
+        n += random_line(src + n, ninsns);
+    }
+    n += sprintf(src + n, "T%d: HALT\n    .org 0x%02X\n", ninsns, SLOT_ADDR);
+    n += sprintf(src + n, "D0:   .byte %d\nD1:   .byte %d\nD2:   .byte 0\n"
+                 "D3:   .byte 255\nOUT1: .byte 0\nOUT2: .byte 0\n", rand() % 4, rand() % 3);
+    return n;
+}
+
+static int fuzz_optimizer(long programs, long *checked, long *before, long *after) {
+    static asm_result plain, opt;
+    char src[4096];
+
+    for (long it = 0; it < programs; it++) {
+        int global = rand() % 2;
+        int alias = global && rand() % 2 ? rand() % 4 : -1;
+        int len = random_source(src, global, alias);
+
+        plain.optimize = 0;
+        opt.optimize = 1;
+        if (asm_assemble(src, (size_t)len, &plain) != 0 ||
+            asm_assemble(src, (size_t)len, &opt) != 0) {
+            printf("ERROR: %s%s\n%s", plain.error, opt.error, src);
+            return 1;
+        }
+
+        // a module with .global is called a second time on the memory
+        // the first call left
+        uint8_t img_a[MEM_SIZE], img_b[MEM_SIZE], mem_a[MEM_SIZE], mem_b[MEM_SIZE];
+        memcpy(img_a, plain.mem, MEM_SIZE);
+        memcpy(img_b, opt.mem, MEM_SIZE);
+        int ok = 1, calls = global ? 2 : 1;
+        for (int k = 0; k < calls && ok; k++) {
+            ref_state_t a, b;
+            if (ref_run(img_a, mem_a, &a, STEP_LIMIT) != 1) {
+                ok = 0;         // does not halt: nothing to compare
+                break;
+            }
+            int rb = ref_run(img_b, mem_b, &b, STEP_LIMIT);
+            int bad = rb != 1 || a.acc != b.acc || a.c != b.c || b.steps > a.steps;
+            for (int v = global ? 4 : 0; v < NSLOTS; v++)
+                if (mem_a[SLOT_ADDR + v] != mem_b[SLOT_ADDR + v]) bad = 1;
+            if (alias >= 0 && mem_a[SLOT_ADDR + alias] != mem_b[SLOT_ADDR + alias]) bad = 1;
+            if (bad) {
+                printf("-O: call %d: ACC=%02X C=%u after %llu steps, "
+                       "expected ACC=%02X C=%u after at most %llu%s%s\n%s",
+                       k + 1, b.acc, b.c, (unsigned long long)b.steps,
+                       a.acc, a.c, (unsigned long long)a.steps,
+                       opt.opt.skipped[0] ? "; skipped: " : "", opt.opt.skipped, src);
+                asm_result_free(&plain);
+                asm_result_free(&opt);
+                return 1;
+            }
+            *before += (long)a.steps;
+            *after  += (long)b.steps;
+            memcpy(img_a, mem_a, MEM_SIZE);
+            memcpy(img_b, mem_b, MEM_SIZE);
+        }
+        if (ok) (*checked)++;
+        asm_result_free(&plain);
+        asm_result_free(&opt);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long programs = argc > 1 ? atol(argv[1]) : 100000;
+    unsigned seed = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 1;
+    long checked = 0, smc = 0, opt_checked = 0, before = 0, after = 0;
+
+    srand(seed);
+    if (fuzz_engines(programs, &checked, &smc) != 0) return 1;
+    printf("engines: %ld halting programs (%ld write their own code), "
+           "%d engines agree with the model\n", checked, smc,
+           CPU_HAVE_THREADED ? NENGINES : NENGINES - 1);
+
+    if (fuzz_optimizer(programs, &opt_checked, &before, &after) != 0) return 1;
+    printf("-O: %ld halting programs agree, %ld -> %ld instructions executed\n",
+           opt_checked, before, after);
+    return 0;
+}
@@ -0,0 +1,158 @@
+// job_pool.c
+// Work-stealing thread pool over an index range (see job_pool.h).
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "job_pool.h"
+#include "cpu_core.h"   // CPU_CACHE_LINE
+
+// ---------------------------------------------------------------------
+// One slice [lo, hi) per worker, each on its own cache line
+// ---------------------------------------------------------------------
+typedef struct {
+    _Alignas(CPU_CACHE_LINE) pthread_mutex_t lock;
+    size_t lo, hi;
+} slice_t;
+
+typedef struct {
+    slice_t *slices;
+    int nworkers;
+    size_t grain;
+    job_fn fn;
+    void *arg;
+    atomic_size_t remaining;   // jobs not yet handed to a worker
+} pool_t;
+
+typedef struct {
+    pool_t *pool;
+    int id;
+} worker_t;
+
+// Take up to `grain` jobs from the front of our own slice.
+static int take_own(pool_t *p, int id, size_t *lo, size_t *hi) {
+    slice_t *s = &p->slices[id];
+    int ok = 0;
+    pthread_mutex_lock(&s->lock);
+    if (s->lo < s->hi) {
+        *lo = s->lo;
+        *hi = (s->hi - s->lo > p->grain) ? s->lo + p->grain : s->hi;
+        s->lo = *hi;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return ok;
+}
+
+// Steal the back half of some other worker's slice into our own.
+static int steal(pool_t *p, int id) {
+    for (int k = 1; k < p->nworkers; k++) {
+        slice_t *v = &p->slices[(id + k) % p->nworkers];
+        size_t lo = 0, hi = 0;
+
+        pthread_mutex_lock(&v->lock);
+        size_t rem = v->hi - v->lo;
+        if (rem > 0) {
+            size_t take = (rem + 1) / 2;
+            hi = v->hi;
+            v->hi -= take;
+            lo = v->hi;
+        }
+        pthread_mutex_unlock(&v->lock);
+
+        if (hi > lo) {
+            slice_t *s = &p->slices[id];
+            pthread_mutex_lock(&s->lock);
+            s->lo = lo;
+            s->hi = hi;
+            pthread_mutex_unlock(&s->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *worker_main(void *vp) {
+    worker_t *w = (worker_t *)vp;
+    pool_t *p = w->pool;
+    size_t lo, hi;
+
+    for (;;) {
+        if (take_own(p, w->id, &lo, &hi)) {
+            atomic_fetch_sub_explicit(&p->remaining, hi - lo,
+                                      memory_order_relaxed);
+            for (size_t i = lo; i < hi; i++) {
+                p->fn(p->arg, i, w->id);
+            }
+            continue;
+        }
+        if (steal(p, w->id)) continue;
+
+        // Nothing visible to steal. Work may still be in flight between
+        // a thief's two lock sections, so only stop once every job has
+        // been handed out.
+        if (atomic_load_explicit(&p->remaining, memory_order_relaxed) == 0)
+            break;
+        sched_yield();
+    }
+    return NULL;
+}
+
+int job_pool_run(size_t njobs, int nworkers, size_t grain,
+                 job_fn fn, void *arg) {
+    if (nworkers < 1) nworkers = 1;
+    if ((size_t)nworkers > njobs && njobs > 0) nworkers = (int)njobs;
+    if (grain < 1) grain = 1;
+
+    pool_t p;
+    p.nworkers = nworkers;
+    p.grain = grain;
+    p.fn = fn;
+    p.arg = arg;
+    atomic_init(&p.remaining, njobs);
+
+    p.slices = aligned_alloc(CPU_CACHE_LINE, sizeof(slice_t) * nworkers);
+    worker_t *workers = malloc(sizeof(worker_t) * nworkers);
+    pthread_t *tids = malloc(sizeof(pthread_t) * nworkers);
+    if (!p.slices || !workers || !tids) {
+        free(p.slices); free(workers); free(tids);
+        return -1;
+    }
+
+    // Initial even split of [0, njobs)
+    for (int i = 0; i < nworkers; i++) {
+        pthread_mutex_init(&p.slices[i].lock, NULL);
+        p.slices[i].lo = njobs * (size_t)i / nworkers;
+        p.slices[i].hi = njobs * (size_t)(i + 1) / nworkers;
+        workers[i].pool = &p;
+        workers[i].id = i;
+    }
+
+    // If a thread cannot be created, the ones we do have steal its slice
+    int started = 1;
+    for (; started < nworkers; started++) {
+        if (pthread_create(&tids[started], NULL, worker_main,
+                           &workers[started]) != 0)
+            break;
+    }
+
+    worker_main(&workers[0]);
+
+    for (int i = 1; i < started; i++) pthread_join(tids[i], NULL);
+    for (int i = 0; i < nworkers; i++) pthread_mutex_destroy(&p.slices[i].lock);
+
+    free(p.slices);
+    free(workers);
+    free(tids);
+    return 0;
+}
+
+int job_pool_default_workers(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
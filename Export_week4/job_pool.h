@@ -0,0 +1,28 @@
+// job_pool.h
+// Small work-stealing thread pool over an index range [0, njobs).
+//
+// Every worker owns a contiguous slice of the range. It takes jobs from
+// the front of its own slice in chunks of `grain`, and when the slice is
+// empty it steals the back half of another worker's slice. Jobs are
+// identified only by their index, so the caller keeps inputs and results
+// in plain arrays and output order is simply index order.
+
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <stddef.h>
+
+// Called once per job. `worker` is 0..nworkers-1 and identifies the
+// calling thread, so per-worker state (e.g. one cpu_t each) needs no locks.
+typedef void (*job_fn)(void *arg, size_t index, int worker);
+
+// Runs fn for every index in [0, njobs) on nworkers threads (the calling
+// thread is worker 0). Returns 0 when every job ran, -1 if the pool
+// could not be allocated.
+int job_pool_run(size_t njobs, int nworkers, size_t grain,
+                 job_fn fn, void *arg);
+
+// Number of online CPUs (at least 1).
+int job_pool_default_workers(void);
+
+#endif // JOB_POOL_H
@@ -1,7 +1,9 @@
 // main2link.c
 // Driver for 8-bit CPU simulator.
 //
-// - Loads factorial.mem and suma.mem (already assembled from factorial.asm / suma.asm)
+// - Loads factorial.obj and suma.obj (already assembled from factorial.asm / suma.asm;
+//   binary objects mapped with mmap, see ../Export_week2/mem_obj.h). Build with
+//   -DFACT_IMAGE='"factorial.mem"' -DSUMA_IMAGE='"suma.mem"' to use the text images.
 // - Passes parameters from C to ASM by writing into memory[] at fixed addresses
 // - Reads back the result from memory[] after each execution.
 //
@@ -17,13 +19,53 @@
 //   A      -> address 0x20  (input FACT1)
 //   B      -> address 0x21  (input FACT2)
 //   RES    -> address 0x22  (output A+B)
+//
+// factorial32.asm / suma32.asm (--wide): the same routines on 32-bit
+// values, stored little endian at consecutive addresses:
+//   N 0xC0, RESULT 0xC1..0xC4;  A 0x20..0x23, B 0x24..0x27, RES 0x28..0x2B
+//
+// Usage:
+//   ./main2link_loadmem.x                         interactive (asks N1, N2)
+//   ./main2link_loadmem.x --batch [FILE] [-j N] [--jit|--aot|--table] [--linked|--wide]   batch mode
+//
+// Batch mode reads "N1 N2" pairs from FILE (or stdin if FILE is missing
+// or "-"), runs factorial(N1), factorial(N2) and suma(FACT1, FACT2) for
+// every pair on a work-stealing thread pool with one cpu_t per worker,
+// and prints "N1 N2 FACT1 FACT2 SUM" lines in input order. Throughput
+// (jobs/sec) is reported on stderr. --jit runs the images through the
+// x86-64 JIT (cpu_jit.c) instead of the interpreter. --table runs nothing:
+// results are looked up in factorial.tab and suma.tab, built by tabulate.
+// --linked loads main2link.obj (factorial.obj + suma.obj packed into one
+// image by ../Export_week2/linker.x) into each worker once and calls the
+// routines at their entry points (globals FACTORIAL / SUMA; inputs and
+// results also found by name) with no image reload between calls.
+// --wide runs factorial32.obj and suma32.obj instead, so results are
+// exact up to 12! rather than reduced mod 256 (interpreter or --jit).
+//
+// Built with -DMAIN2LINK_AOT (and the factorial_aot.c / suma_aot.c files
+// generated by mem2c), both images are linked in as native C functions:
+// the interactive mode runs them instead of load_module() +
+// fetch_decode_execute(), and batch mode accepts --aot.
+
+#define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+
+#include "cpu_core.h"
+#include "cpu_jit.h"
+#include "job_pool.h"
+#include "mem_image.h"
+#include "mem_table.h"
+#include "../Export_week2/mem_obj.h"
 
-#define MEM_SIZE 256
+#ifdef MAIN2LINK_AOT
+#include "factorial_aot.h"
+#include "suma_aot.h"
+#endif
 
 // Addresses must match the ASM layout
 #define N_ADDR       0xC0   // N in factorial.asm
@@ -33,68 +75,403 @@
 #define B_ADDR       0x21   // B in suma.asm
 #define RES_ADDR     0x22   // RES in suma.asm
 
-// ---------------------------------------------------------------------
-// Externals provided by the CPU core (cpu_core.c / cpu_simulator*.c)
-// ---------------------------------------------------------------------
-extern uint8_t  memory[];           // 256-byte memory of the simulated CPU
-extern uint8_t  ACC;                // accumulator (optional, for debug)
-extern uint16_t PC;                 // program counter (optional, for debug)
-extern uint8_t  IR;                 // instruction register (optional, for debug)
+#define WIDE_BYTES   4      // --wide: bytes of every value
+#define A32_ADDR     0x20   // A in suma32.asm (N and RESULT as in factorial.asm)
+#define B32_ADDR     0x24   // B in suma32.asm
+#define RES32_ADDR   0x28   // RES in suma32.asm
 
-extern void cpu_reset(void);        // reset ACC, PC, IR
-extern void fetch_decode_execute(void);  // run until HALT or error
+#ifndef FACT_IMAGE
+#define FACT_IMAGE   "factorial.obj"
+#endif
+#ifndef SUMA_IMAGE
+#define SUMA_IMAGE   "suma.obj"
+#endif
+#define LINK_IMAGE   "main2link.obj"    // both modules, made by linker.x
+#define FACT32_IMAGE "factorial32.obj"
+#define SUMA32_IMAGE "suma32.obj"
 
+#ifndef MAIN2LINK_AOT
 // ---------------------------------------------------------------------
-// Load a .mem file (one hex byte per line) into memory[]
+// Load an image (.obj, .bin or .mem) into memory[]
+//
+// The file is read only the first time (or when it changes on disk);
+// every later call restores the cached snapshot with a single copy.
 // ---------------------------------------------------------------------
 static void load_module(const char *fname) {
-    FILE *f = fopen(fname, "r");
-    if (!f) {
-        perror(fname);
+    const uint8_t *img = mem_image_get(fname);
+    if (!img) {
         exit(1);
     }
-
-    // Clear full memory before loading new module
-    memset(memory, 0, MEM_SIZE);
-
-    unsigned int val;
-    int addr = 0;
-
-    while (fscanf(f, "%x", &val) == 1) {
-        if (addr >= MEM_SIZE) break;
-        memory[addr++] = (uint8_t)val;
-    }
-
-    fclose(f);
+    memcpy(memory, img, MEM_SIZE);
 }
+#endif
 
 // ---------------------------------------------------------------------
-// Run factorial.mem for a given N value.
+// Run the factorial image for a given N value.
 //
-// 1) Load factorial.mem into memory[]
-// 2) cpu_reset() to set PC=0, ACC=0, IR=0
+// 1) Load FACT_IMAGE into memory[]
+// 2) cpu_reset_default() to set PC=0, ACC=0, IR=0
 // 3) Write N into memory[N_ADDR]
 // 4) fetch_decode_execute() to run ASM
 // 5) Return memory[RESULT_ADDR] as the factorial
+//
+// With MAIN2LINK_AOT, steps 1 and 4 use the linked-in factorial_aot_image
+// and factorial_aot_run() instead.
 // ---------------------------------------------------------------------
 static uint8_t run_factorial(uint8_t n_value) {
-    load_module("factorial.mem");
-    cpu_reset();
+#ifdef MAIN2LINK_AOT
+    cpu_load(&cpu_default, factorial_aot_image);
+    cpu_reset(&cpu_default);
+#else
+    load_module(FACT_IMAGE);
+    cpu_reset_default();
+#endif
 
     // Pass the parameter from C to ASM:
     // N is at fixed address N_ADDR in RAM
     memory[N_ADDR] = n_value;
 
+#ifdef MAIN2LINK_AOT
+    factorial_aot_run(&cpu_default);
+#else
     fetch_decode_execute();
+#endif
 
     // Read back the result from fixed address RESULT_ADDR
     return memory[RESULT_ADDR];
 }
 
+// ---------------------------------------------------------------------
+// Batch mode
+// ---------------------------------------------------------------------
+typedef struct {
+    int n1, n2;
+    uint32_t fact1, fact2, sum;     // < 256 unless --wide
+} batch_job_t;
+
+// Addresses of the routines and their arguments inside LINK_IMAGE
+typedef struct {
+    uint8_t fact_entry, n, result;
+    uint8_t suma_entry, a, b, res;
+} link_addrs_t;
+
+typedef struct {
+    uint8_t fact_img[MEM_SIZE];   // FACT_IMAGE, read once
+    uint8_t suma_img[MEM_SIZE];   // SUMA_IMAGE, read once
+    batch_job_t *jobs;
+    cpu_t *cpus;                  // one context per worker
+    cpu_jit_t **jits;             // --jit: FACT_JIT/SUMA_JIT per worker, else NULL
+    int aot;                      // --aot: run the linked-in native functions
+    const mem_table_t *fact_tab;  // --table: precomputed results, else NULL
+    const mem_table_t *suma_tab;
+    int linked;                   // --linked: every cpu holds LINK_IMAGE
+    link_addrs_t link;
+    int width;                    // bytes per value: 1, or WIDE_BYTES with --wide
+    uint8_t a, b, res;            // suma's arguments for that width
+} batch_t;
+
+// Each worker keeps one JIT per image, so alternating factorial and
+// suma runs never throw away the other image's translated code.
+enum { FACT_JIT, SUMA_JIT, JITS_PER_WORKER };
+
+static void run_image(batch_t *b, cpu_t *c, int worker, int image) {
+#ifdef MAIN2LINK_AOT
+    if (b->aot) {
+        if (image == FACT_JIT) factorial_aot_run(c);
+        else                   suma_aot_run(c);
+        return;
+    }
+#endif
+    if (b->jits) {
+        cpu_jit_run(b->jits[worker * JITS_PER_WORKER + image], c);
+    } else {
+        cpu_run(c);
+    }
+}
+
+// Copy a pristine image into the context and reset its registers.
+// cpu_load() only touches the bytes the previous run changed, so the
+// decoded instructions of the image stay cached from job to job.
+static void restore_image(cpu_t *c, const uint8_t img[MEM_SIZE]) {
+    cpu_load(c, img);
+    cpu_reset(c);
+}
+
+// Values wider than a byte live little endian at consecutive addresses
+static uint32_t read_value(const cpu_t *c, uint8_t addr, int width) {
+    uint32_t v = 0;
+    for (int k = width - 1; k >= 0; k--)
+        v = v << 8 | c->mem[(uint8_t)(addr + k)];
+    return v;
+}
+
+static void write_value(cpu_t *c, uint8_t addr, uint32_t v, int width) {
+    for (int k = 0; k < width; k++)
+        cpu_write(c, (uint8_t)(addr + k), (uint8_t)(v >> 8 * k));
+}
+
+// --linked: call the routine at entry in the image the context already
+// holds. The routines only write their own data, so nothing is reloaded;
+// one JIT per worker covers both.
+static void call_linked(batch_t *b, cpu_t *c, int worker, uint8_t entry) {
+    cpu_reset(c);
+    c->PC = entry;
+    run_image(b, c, worker, FACT_JIT);
+}
+
+static void batch_job(void *arg, size_t index, int worker) {
+    batch_t *b = (batch_t *)arg;
+    batch_job_t *j = &b->jobs[index];
+    cpu_t *c = &b->cpus[worker];
+
+    if (b->linked) {
+        const link_addrs_t *L = &b->link;
+        cpu_write(c, L->n, (uint8_t)j->n1);
+        call_linked(b, c, worker, L->fact_entry);
+        j->fact1 = c->mem[L->result];
+
+        cpu_write(c, L->n, (uint8_t)j->n2);
+        call_linked(b, c, worker, L->fact_entry);
+        j->fact2 = c->mem[L->result];
+
+        cpu_write(c, L->a, (uint8_t)j->fact1);
+        cpu_write(c, L->b, (uint8_t)j->fact2);
+        call_linked(b, c, worker, L->suma_entry);
+        j->sum = c->mem[L->res];
+        return;
+    }
+
+    if (b->fact_tab) {
+        // O(1): every possible run is already in the tables
+        j->fact1 = mem_table_get1(b->fact_tab, (uint8_t)j->n1);
+        j->fact2 = mem_table_get1(b->fact_tab, (uint8_t)j->n2);
+        j->sum   = mem_table_get2(b->suma_tab, (uint8_t)j->fact1, (uint8_t)j->fact2);
+        return;
+    }
+
+    restore_image(c, b->fact_img);
+    cpu_write(c, N_ADDR, (uint8_t)j->n1);
+    run_image(b, c, worker, FACT_JIT);
+    j->fact1 = read_value(c, RESULT_ADDR, b->width);
+
+    restore_image(c, b->fact_img);
+    cpu_write(c, N_ADDR, (uint8_t)j->n2);
+    run_image(b, c, worker, FACT_JIT);
+    j->fact2 = read_value(c, RESULT_ADDR, b->width);
+
+    restore_image(c, b->suma_img);
+    write_value(c, b->a, j->fact1, b->width);
+    write_value(c, b->b, j->fact2, b->width);
+    run_image(b, c, worker, SUMA_JIT);
+    j->sum = read_value(c, b->res, b->width);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Load a table built by tabulate and check that it was made from this
+// image and for the addresses this driver uses.
+static int load_table(mem_table_t *t, const char *fname, const uint8_t img[MEM_SIZE],
+                      int ninputs, uint8_t in0, uint8_t in1, uint8_t out) {
+    if (mem_table_load(t, fname) != 0) return -1;
+    if (t->image_hash != mem_table_hash(img) || t->ninputs != ninputs ||
+        t->in[0] != in0 || (ninputs == 2 && t->in[1] != in1) || t->out != out) {
+        fprintf(stderr, "%s: built from another image or other addresses "
+                "(run tabulate again)\n", fname);
+        return -1;
+    }
+    return 0;
+}
+
+// Load LINK_IMAGE into img and look up the addresses the driver needs
+static int load_linked(uint8_t img[MEM_SIZE], link_addrs_t *L) {
+    static const char *const names[] = { "FACTORIAL", "N", "RESULT", "SUMA", "A", "B", "RES" };
+    uint8_t *addr[] = { &L->fact_entry, &L->n, &L->result, &L->suma_entry, &L->a, &L->b, &L->res };
+    mem_obj_t obj;
+
+    if (mem_obj_map(&obj, LINK_IMAGE) != 0) return -1;
+    mem_obj_load(&obj, img);
+    for (size_t i = 0; i < sizeof names / sizeof names[0]; i++) {
+        int v = mem_obj_find(&obj, names[i]);
+        if (v < 0) {
+            fprintf(stderr, "%s: no global symbol %s\n", LINK_IMAGE, names[i]);
+            mem_obj_unmap(&obj);
+            return -1;
+        }
+        *addr[i] = (uint8_t)v;
+    }
+    mem_obj_unmap(&obj);
+    return 0;
+}
+
+static void free_jits(batch_t *b, int n) {
+    if (!b->jits) return;
+    for (int i = 0; i < n; i++) cpu_jit_free(b->jits[i]);
+    free(b->jits);
+}
+
+static int run_batch(const char *input, int nworkers, int use_jit, int use_aot,
+                     int use_table, int use_linked, int use_wide) {
+    batch_t b;
+    b.jits = NULL;
+    b.aot = use_aot;
+    b.fact_tab = b.suma_tab = NULL;
+    b.linked = use_linked;
+    b.width = use_wide ? WIDE_BYTES : 1;
+    b.a   = use_wide ? A32_ADDR : A_ADDR;
+    b.b   = use_wide ? B32_ADDR : B_ADDR;
+    b.res = use_wide ? RES32_ADDR : RES_ADDR;
+
+    static uint8_t link_img[MEM_SIZE];
+    if (use_linked && load_linked(link_img, &b.link) != 0) return 1;
+#ifdef MAIN2LINK_AOT
+    if (use_aot) {
+        memcpy(b.fact_img, factorial_aot_image, MEM_SIZE);
+        memcpy(b.suma_img, suma_aot_image, MEM_SIZE);
+    } else
+#endif
+    {
+        const uint8_t *fact = mem_image_get(use_wide ? FACT32_IMAGE : FACT_IMAGE);
+        const uint8_t *suma = mem_image_get(use_wide ? SUMA32_IMAGE : SUMA_IMAGE);
+        if (!fact || !suma) return 1;
+        memcpy(b.fact_img, fact, MEM_SIZE);
+        memcpy(b.suma_img, suma, MEM_SIZE);
+    }
+
+    static mem_table_t fact_tab, suma_tab;
+    if (use_table) {
+        if (load_table(&fact_tab, "factorial.tab", b.fact_img, 1, N_ADDR, 0, RESULT_ADDR) != 0 ||
+            load_table(&suma_tab, "suma.tab", b.suma_img, 2, A_ADDR, B_ADDR, RES_ADDR) != 0)
+            return 1;
+        b.fact_tab = &fact_tab;
+        b.suma_tab = &suma_tab;
+    }
+
+    FILE *in = stdin;
+    if (input && strcmp(input, "-") != 0) {
+        in = fopen(input, "r");
+        if (!in) {
+            perror(input);
+            return 1;
+        }
+    }
+
+    // Read all (N1, N2) pairs
+    size_t njobs = 0, cap = 1024;
+    b.jobs = malloc(cap * sizeof(batch_job_t));
+    int n1, n2;
+    while (b.jobs && fscanf(in, "%d %d", &n1, &n2) == 2) {
+        if (njobs == cap) {
+            cap *= 2;
+            batch_job_t *grown = realloc(b.jobs, cap * sizeof(batch_job_t));
+            if (!grown) { free(b.jobs); b.jobs = NULL; break; }
+            b.jobs = grown;
+        }
+        b.jobs[njobs].n1 = n1;
+        b.jobs[njobs].n2 = n2;
+        njobs++;
+    }
+    if (in != stdin) fclose(in);
+    if (!b.jobs) {
+        fprintf(stderr, "batch: out of memory\n");
+        return 1;
+    }
+
+    if (nworkers < 1) nworkers = job_pool_default_workers();
+    b.cpus = aligned_alloc(CPU_CACHE_LINE, sizeof(cpu_t) * nworkers);
+    if (!b.cpus) {
+        fprintf(stderr, "batch: out of memory\n");
+        free(b.jobs);
+        return 1;
+    }
+    for (int i = 0; i < nworkers; i++) {
+        cpu_init(&b.cpus[i]);
+        if (use_linked) cpu_load(&b.cpus[i], link_img);   // once, for every job
+    }
+
+    int njits = nworkers * JITS_PER_WORKER;
+    if (use_jit) {
+        b.jits = calloc((size_t)njits, sizeof(cpu_jit_t *));
+        for (int i = 0; b.jits && i < njits; i++) {
+            if (!(b.jits[i] = cpu_jit_new())) {
+                fprintf(stderr, "batch: JIT not available, using the interpreter\n");
+                free_jits(&b, i);
+                b.jits = NULL;
+            }
+        }
+    }
+
+    double t0 = now_sec();
+    int rc = job_pool_run(njobs, nworkers, 256, batch_job, &b);
+    double dt = now_sec() - t0;
+
+    if (rc == 0) {
+        for (size_t i = 0; i < njobs; i++) {
+            const batch_job_t *j = &b.jobs[i];
+            printf("%d %d %u %u %u\n", j->n1, j->n2, j->fact1, j->fact2, j->sum);
+        }
+        fprintf(stderr, "batch: %zu jobs, %d workers, %.3f s, %.0f jobs/s\n",
+                njobs, nworkers, dt, dt > 0 ? (double)njobs / dt : 0.0);
+    } else {
+        fprintf(stderr, "batch: could not start the job pool\n");
+    }
+
+    free_jits(&b, njits);
+    free(b.cpus);
+    free(b.jobs);
+    return rc == 0 ? 0 : 1;
+}
+
 // ---------------------------------------------------------------------
 // main()
 // ---------------------------------------------------------------------
-int main(void) {
+// An option that cannot run with another: say why, then how to call it
+static int batch_usage(const char *prog, const char *why) {
+    fprintf(stderr, "%s\n", why);
+    fprintf(stderr, "Usage: %s --batch [FILE] [-j N] [--jit|--aot|--table] [--linked|--wide]\n"
+                    "       --linked and --wide run the interpreter or --jit\n", prog);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        const char *input = NULL;
+        int nworkers = 0, use_jit = 0, use_aot = 0, use_table = 0, use_linked = 0, use_wide = 0;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                nworkers = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--jit") == 0) {
+                use_jit = 1;
+            } else if (strcmp(argv[i], "--table") == 0) {
+                use_table = 1;
+            } else if (strcmp(argv[i], "--linked") == 0) {
+                use_linked = 1;
+            } else if (strcmp(argv[i], "--wide") == 0) {
+                use_wide = 1;
+            } else if (strcmp(argv[i], "--aot") == 0) {
+#ifdef MAIN2LINK_AOT
+                use_aot = 1;
+#else
+                fprintf(stderr, "--aot needs a build with -DMAIN2LINK_AOT\n");
+                return 1;
+#endif
+            } else {
+                input = argv[i];
+            }
+        }
+        if (use_linked && (use_aot || use_table))
+            return batch_usage(argv[0], "--linked cannot be combined with --aot or --table");
+        if (use_wide && (use_aot || use_table))
+            return batch_usage(argv[0], "--wide cannot be combined with --aot or --table");
+        if (use_wide && use_linked)
+            return batch_usage(argv[0], "--wide cannot be combined with --linked "
+                                        "(main2link.obj holds the 8-bit routines)");
+        return run_batch(input, nworkers, use_jit, use_aot, use_table, use_linked, use_wide);
+    }
+
     int N1, N2;
 
     printf("Introduce N1: ");
@@ -129,14 +506,23 @@ int main(void) {
     //   B at B_ADDR
     //   RES at RES_ADDR
     // ------------------------------
-    load_module("suma.mem");
-    cpu_reset();
+#ifdef MAIN2LINK_AOT
+    cpu_load(&cpu_default, suma_aot_image);
+    cpu_reset(&cpu_default);
+#else
+    load_module(SUMA_IMAGE);
+    cpu_reset_default();
+#endif
 
     // Pass both parameters into fixed RAM slots
     memory[A_ADDR] = FACT1;
     memory[B_ADDR] = FACT2;
 
+#ifdef MAIN2LINK_AOT
+    suma_aot_run(&cpu_default);
+#else
     fetch_decode_execute();
+#endif
 
     uint8_t SUM = memory[RES_ADDR];
 
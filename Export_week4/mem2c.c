@@ -0,0 +1,307 @@
+// mem2c.c
+// Ahead-of-time translator: turns an assembled image (.mem or .bin) into
+// a C source file with one function that runs it natively.
+//
+// Usage: ./mem2c.x image.mem|.bin|.obj NAME   (writes NAME_aot.c and NAME_aot.h)
+//
+// The generated file defines
+//   const uint8_t NAME_aot_image[MEM_SIZE];   the image itself
+//   int NAME_aot_run(cpu_t *c);               same contract as cpu_run()
+//
+// Every instruction reachable from PC 0 becomes a labelled statement
+// (L_xx, xx = guest PC); jumps become gotos, so the host compiler sees
+// the guest's loops and keeps ACC in a register. ACC stays uint8_t, so
+// additions wrap modulo 256 exactly as in the interpreter; the carry flag
+// is a local too, and the compiler drops the updates nobody reads.
+//
+// The translation is only valid while the code bytes are those of the
+// image, so NAME_aot_run() hands the context to cpu_run() when
+//   - the entry PC is not the start of a translated instruction, or
+//   - a STORE writes a code byte (self-modifying code; for STOREP and
+//     STOREX, whose address is only known at run time, a table of the
+//     code bytes is checked),
+// and the interpreter continues from exactly that state. Data bytes
+// (inputs at fixed addresses) may differ freely from the image.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cpu_core.h"
+#include "mem_image.h"
+
+typedef struct {
+    uint8_t img[MEM_SIZE];
+    uint8_t reach[MEM_SIZE];    // 1 = an instruction starts here
+    uint8_t code[MEM_SIZE];     // 1 = byte of some reachable instruction
+    int has_out;                // HALT or unknown opcode reachable
+    int has_computed_store;     // STOREP or STOREX reachable
+} image_t;
+
+// Successors of the instruction at pc (0, 1 or 2)
+static int successors(const image_t *m, uint8_t pc, uint8_t succ[2]) {
+    uint8_t op = m->img[pc], arg = m->img[(uint8_t)(pc + 1)];
+    uint8_t next = (uint8_t)(pc + cpu_insn_len(op));
+    if (op == HALT || !isa_find(op))    // HALT, unknown opcode
+        return 0;
+    if (isa_kind(op) != ISA_JUMP) {
+        succ[0] = next;
+        return 1;
+    }
+    succ[0] = arg;
+    if (op == JMP)
+        return 1;
+    succ[1] = next;                     // JZ, JNZ, JC
+    return 2;
+}
+
+// Recursive descent from PC 0
+static void discover(image_t *m) {
+    uint8_t work[MEM_SIZE];
+    int top = 0;
+
+    work[top++] = 0;
+    m->reach[0] = 1;
+    while (top > 0) {
+        uint8_t pc = work[--top], succ[2];
+        int n = successors(m, pc, succ);
+        for (int i = 0; i < n; i++) {
+            if (!m->reach[succ[i]]) {
+                m->reach[succ[i]] = 1;
+                work[top++] = succ[i];
+            }
+        }
+    }
+
+    for (int pc = 0; pc < MEM_SIZE; pc++) {
+        if (!m->reach[pc]) continue;
+        uint8_t op = m->img[pc];
+        for (int k = 0; k < cpu_insn_len(op); k++)
+            m->code[(uint8_t)(pc + k)] = 1;
+        if (op == HALT || !isa_find(op))
+            m->has_out = 1;
+        if (op == STOREP || op == STOREX)
+            m->has_computed_store = 1;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Code generation
+// ---------------------------------------------------------------------
+static void emit_insn(FILE *f, const image_t *m, uint8_t pc) {
+    uint8_t op = m->img[pc], arg = m->img[(uint8_t)(pc + 1)];
+    uint8_t next = (uint8_t)(pc + cpu_insn_len(op));
+
+    fprintf(f, "L_%02X: steps++; ", pc);
+    switch (op) {
+    case NOP:
+        fprintf(f, "/* NOP */");
+        break;
+    case LOAD:
+        fprintf(f, "acc = mem[0x%02X];", arg);
+        break;
+    case ADD:
+        fprintf(f, "{ unsigned t = acc + mem[0x%02X]; acc = (uint8_t)t; cy = t >> 8; }", arg);
+        break;
+    case ADC:
+        fprintf(f, "{ unsigned t = acc + mem[0x%02X] + cy; acc = (uint8_t)t; cy = t >> 8; }", arg);
+        break;
+    case MUL:
+        fprintf(f, "acc = (uint8_t)(acc * mem[0x%02X]);", arg);
+        break;
+    case SUB:
+        fprintf(f, "{ unsigned t = acc - mem[0x%02X]; acc = (uint8_t)t; cy = (t >> 8) & 1; }", arg);
+        break;
+    case SBC:
+        fprintf(f, "{ unsigned t = acc - mem[0x%02X] - cy; acc = (uint8_t)t; cy = (t >> 8) & 1; }", arg);
+        break;
+    case LOADI:
+        fprintf(f, "acc = 0x%02X;", arg);
+        break;
+    case ADDI:
+        fprintf(f, "{ unsigned t = acc + 0x%02Xu; acc = (uint8_t)t; cy = t >> 8; }", arg);
+        break;
+    case SUBI:
+        fprintf(f, "{ unsigned t = acc - 0x%02Xu; acc = (uint8_t)t; cy = (t >> 8) & 1; }", arg);
+        break;
+    case STORE:
+        fprintf(f, "mem[0x%02X] = acc; cpu_dec_invalidate(c, 0x%02X);", arg, arg);
+        if (m->code[arg])
+            fprintf(f, " pc = 0x%02X; goto interp;   /* writes code */", next);
+        break;
+    case LOADP:
+        fprintf(f, "acc = mem[mem[0x%02X]];", arg);
+        break;
+    case ADDP:
+        fprintf(f, "{ unsigned t = acc + mem[mem[0x%02X]]; acc = (uint8_t)t; cy = t >> 8; }", arg);
+        break;
+    case STOREP:
+    case STOREX:
+        if (op == STOREP)
+            fprintf(f, "{ uint8_t a = mem[0x%02X]; ", arg);
+        else
+            fprintf(f, "{ uint8_t a = (uint8_t)(0x%02X + x); ", arg);
+        fprintf(f, "mem[a] = acc; cpu_dec_invalidate(c, a); "
+                "if (code[a]) { pc = 0x%02X; goto interp; } }", next);
+        break;
+    case LOADX:
+        fprintf(f, "acc = mem[(uint8_t)(0x%02X + x)];", arg);
+        break;
+    case ADDX:
+        fprintf(f, "{ unsigned t = acc + mem[(uint8_t)(0x%02X + x)]; acc = (uint8_t)t; cy = t >> 8; }", arg);
+        break;
+    case INX:
+        fprintf(f, "x++;");
+        break;
+    case DEX:
+        fprintf(f, "x--;");
+        break;
+    case TAX:
+        fprintf(f, "x = acc;");
+        break;
+    case TXA:
+        fprintf(f, "acc = x;");
+        break;
+    case JMP:
+        fprintf(f, "goto L_%02X;", arg);
+        break;
+    case JZ:
+        fprintf(f, "if (acc == 0) goto L_%02X;", arg);
+        break;
+    case JNZ:
+        fprintf(f, "if (acc != 0) goto L_%02X;", arg);
+        break;
+    case JC:
+        fprintf(f, "if (cy) goto L_%02X;", arg);
+        break;
+    case PRINT:
+        fprintf(f, "printf(\"[CPU] ACC=%%3u (0x%%02X), PC=0x%%02X\\n\", acc, acc, 0x%02X);",
+                next);
+        break;
+    case HALT:
+        fprintf(f, "pc = 0x%02X; ir = 0x%02X; status = 0; goto out;", next, op);
+        break;
+    default:
+        fprintf(f, "pc = 0x%02X; ir = 0x%02X; "
+                "printf(\"Unknown opcode 0x%02X at PC=0x%02X\\n\"); status = -1; goto out;",
+                next, op, op, pc);
+        break;
+    }
+    fputc('\n', f);
+}
+
+// Next translated PC after pc in emission (address) order, -1 if none
+static int next_emitted(const image_t *m, int pc) {
+    for (int a = pc + 1; a < MEM_SIZE; a++)
+        if (m->reach[a]) return a;
+    return -1;
+}
+
+static void emit_c(FILE *f, const image_t *m, const char *name, const char *src) {
+    fprintf(f, "// %s_aot.c -- generated by mem2c from %s. Do not edit.\n\n", name, src);
+    fprintf(f, "#include <stdio.h>\n#include <stdint.h>\n\n#include \"%s_aot.h\"\n\n", name);
+
+    fprintf(f, "const uint8_t %s_aot_image[MEM_SIZE] = {", name);
+    for (int a = 0; a < MEM_SIZE; a++)
+        fprintf(f, "%s0x%02X,", a % 16 ? " " : "\n    ", m->img[a]);
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "int %s_aot_run(cpu_t *c) {\n", name);
+    fprintf(f, "    uint8_t *mem = c->mem;\n");
+    fprintf(f, "    uint8_t acc = c->ACC, cy = c->C, x = c->X, pc = c->PC;\n");
+    fprintf(f, "    uint64_t steps = c->steps;\n");
+    if (m->has_out)
+        fprintf(f, "    uint8_t ir;\n    int status;\n");
+    if (m->has_computed_store) {
+        fprintf(f, "    // code bytes: a STOREP/STOREX there leaves the translation\n");
+        fprintf(f, "    static const uint8_t code[MEM_SIZE] = {");
+        for (int a = 0; a < MEM_SIZE; a++)
+            fprintf(f, "%s%d,", a % 32 ? " " : "\n        ", m->code[a]);
+        fprintf(f, "\n    };\n");
+    }
+    fprintf(f, "\n    switch (pc) {\n");
+    for (int a = 0; a < MEM_SIZE; a++)
+        if (m->reach[a]) fprintf(f, "    case 0x%02X: goto L_%02X;\n", a, a);
+    fprintf(f, "    default: goto interp;\n    }\n\n");
+
+    for (int a = 0; a < MEM_SIZE; a++) {
+        if (!m->reach[a]) continue;
+        emit_insn(f, m, (uint8_t)a);
+
+        uint8_t succ[2];
+        int n = successors(m, (uint8_t)a, succ);
+        uint8_t op = m->img[a];
+        if (op == JMP || n == 0) continue;
+        uint8_t fall = succ[n - 1];
+        if (next_emitted(m, a) != fall)
+            fprintf(f, "      goto L_%02X;\n", fall);
+    }
+
+    fprintf(f, "\ninterp:\n");
+    fprintf(f, "    // code modified or PC outside the translation\n");
+    fprintf(f, "    c->ACC = acc;\n    c->C = cy;\n    c->X = x;\n    c->PC = pc;\n    c->steps = steps;\n");
+    fprintf(f, "    return cpu_run(c);\n");
+    if (m->has_out) {
+        fprintf(f, "\nout:\n");
+        fprintf(f, "    c->ACC = acc;\n    c->C = cy;\n    c->X = x;\n    c->PC = pc;\n    c->IR = ir;\n    c->steps = steps;\n");
+        fprintf(f, "    return status;\n");
+    }
+    fprintf(f, "}\n");
+}
+
+static void emit_h(FILE *f, const char *name, const char *src) {
+    char guard[128];
+    size_t i;
+    for (i = 0; name[i] && i < sizeof guard - 8; i++)
+        guard[i] = (char)toupper((unsigned char)name[i]);
+    strcpy(guard + i, "_AOT_H");
+
+    fprintf(f, "// %s_aot.h -- generated by mem2c from %s. Do not edit.\n\n", name, src);
+    fprintf(f, "#ifndef %s\n#define %s\n\n#include \"cpu_core.h\"\n\n", guard, guard);
+    fprintf(f, "extern const uint8_t %s_aot_image[MEM_SIZE];\n\n", name);
+    fprintf(f, "// Runs c like cpu_run(); c->mem must hold the code of %s_aot_image.\n", name);
+    fprintf(f, "int %s_aot_run(cpu_t *c);\n\n#endif // %s\n", name, guard);
+}
+
+static int valid_name(const char *s) {
+    if (!*s || isdigit((unsigned char)*s)) return 0;
+    for (; *s; s++)
+        if (!isalnum((unsigned char)*s) && *s != '_') return 0;
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s image.mem|image.bin|image.obj NAME\n", argv[0]);
+        return 1;
+    }
+    const char *src = argv[1], *name = argv[2];
+    if (!valid_name(name) || strlen(name) > 100) {
+        fprintf(stderr, "mem2c: NAME must be a C identifier\n");
+        return 1;
+    }
+
+    static image_t m;
+    if (mem_image_read_any(src, m.img) < 0) return 1;
+    discover(&m);
+
+    char path[128];
+    snprintf(path, sizeof path, "%s_aot.c", name);
+    FILE *fc = fopen(path, "w");
+    if (!fc) { perror(path); return 1; }
+    emit_c(fc, &m, name, src);
+    fclose(fc);
+
+    snprintf(path, sizeof path, "%s_aot.h", name);
+    FILE *fh = fopen(path, "w");
+    if (!fh) { perror(path); return 1; }
+    emit_h(fh, name, src);
+    fclose(fh);
+
+    int ninsn = 0;
+    for (int a = 0; a < MEM_SIZE; a++) ninsn += m.reach[a];
+    printf("Translated %s -> %s_aot.{c,h} (%d instructions)\n", src, name, ninsn);
+    return 0;
+}
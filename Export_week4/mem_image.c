@@ -0,0 +1,126 @@
+// mem_image.c
+// Loading of assembled images (see mem_image.h).
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "mem_image.h"
+#include "../Export_week2/mem_obj.h"
+
+int mem_image_read(const char *fname, uint8_t img[MEM_SIZE]) {
+    FILE *f = fopen(fname, "r");
+    if (!f) {
+        perror(fname);
+        return -1;
+    }
+
+    // Clear full memory before loading new module
+    memset(img, 0, MEM_SIZE);
+
+    unsigned int val;
+    int addr = 0;
+
+    while (fscanf(f, "%x", &val) == 1) {
+        if (addr >= MEM_SIZE) break;
+        img[addr++] = (uint8_t)val;
+    }
+
+    fclose(f);
+    return addr;
+}
+
+int mem_image_read_bin(const char *fname, uint8_t img[MEM_SIZE]) {
+    FILE *f = fopen(fname, "rb");
+    if (!f) {
+        perror(fname);
+        return -1;
+    }
+
+    memset(img, 0, MEM_SIZE);
+    size_t n = fread(img, 1, MEM_SIZE, f);
+
+    fclose(f);
+    return (int)n;
+}
+
+int mem_image_read_obj(const char *fname, uint8_t img[MEM_SIZE]) {
+    mem_obj_t obj;
+    if (mem_obj_map(&obj, fname) != 0) return -1;
+
+    int n = mem_obj_load(&obj, img);
+    mem_obj_unmap(&obj);
+    return n;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+int mem_image_read_any(const char *fname, uint8_t img[MEM_SIZE]) {
+    if (ends_with(fname, ".obj")) return mem_image_read_obj(fname, img);
+    if (ends_with(fname, ".bin")) return mem_image_read_bin(fname, img);
+    return mem_image_read(fname, img);
+}
+
+// ---------------------------------------------------------------------
+// Registry
+// ---------------------------------------------------------------------
+typedef struct {
+    char           *path;
+    off_t           size;       // st_size / st_mtim at the last parse
+    struct timespec mtime;
+    uint8_t         img[MEM_SIZE];
+} mem_image_entry_t;
+
+static mem_image_entry_t registry[MEM_IMAGE_MAX];
+static int nregistry;
+
+const uint8_t *mem_image_get(const char *fname) {
+    struct stat st;
+    if (stat(fname, &st) != 0) {
+        perror(fname);
+        return NULL;
+    }
+
+    mem_image_entry_t *e = NULL;
+    for (int i = 0; i < nregistry; i++) {
+        if (strcmp(registry[i].path, fname) == 0) {
+            e = &registry[i];
+            break;
+        }
+    }
+
+    if (e) {
+        if (e->size == st.st_size &&
+            e->mtime.tv_sec == st.st_mtim.tv_sec &&
+            e->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            return e->img;      // unchanged on disk
+        }
+    } else {
+        if (nregistry == MEM_IMAGE_MAX) {
+            fprintf(stderr, "%s: image registry full (%d files)\n", fname, MEM_IMAGE_MAX);
+            return NULL;
+        }
+        e = &registry[nregistry];
+        e->path = malloc(strlen(fname) + 1);
+        if (!e->path) {
+            perror(fname);
+            return NULL;
+        }
+        strcpy(e->path, fname);
+        nregistry++;
+    }
+
+    // New or modified: parse again. On failure the entry keeps a size of
+    // -1 so the next call retries.
+    e->size = -1;
+    if (mem_image_read_any(fname, e->img) < 0) return NULL;
+    e->size  = st.st_size;
+    e->mtime = st.st_mtim;
+    return e->img;
+}
@@ -0,0 +1,46 @@
+// mem_image.h
+// Loading of assembled images into a plain 256-byte buffer, shared by the
+// drivers and tools in this folder: .mem (text hex, one byte per line),
+// .bin (raw bytes from address 0) or .obj (load segments, mapped with
+// mmap; format in ../Export_week2/mem_obj.h).
+
+#ifndef MEM_IMAGE_H
+#define MEM_IMAGE_H
+
+#include <stdint.h>
+
+#include "cpu_core.h"
+
+// Read a .mem file into img[], zero-filling the rest of the 256 bytes.
+// Returns the number of bytes the file holds (its image is
+// img[0..n-1]), or -1 (after perror) if it cannot be opened.
+int mem_image_read(const char *fname, uint8_t img[MEM_SIZE]);
+
+// Same for a .bin file.
+int mem_image_read_bin(const char *fname, uint8_t img[MEM_SIZE]);
+
+// Same for a .obj file (the result is one past its highest segment byte).
+// Reports and returns -1 if the file is not a valid object.
+int mem_image_read_obj(const char *fname, uint8_t img[MEM_SIZE]);
+
+// Picks one of the above by extension (.obj, .bin, anything else .mem).
+int mem_image_read_any(const char *fname, uint8_t img[MEM_SIZE]);
+
+// ---------------------------------------------------------------------
+// Registry of parsed images
+//
+// mem_image_get() reads an image (mem_image_read_any) the first time it is asked for and
+// keeps the pristine 256-byte snapshot; later calls only stat() the file
+// and parse it again if its size or modification time changed. A run then
+// restores the snapshot with one copy (or cpu_load(), which only rewrites
+// the bytes the previous run changed) instead of fopen + fscanf per byte.
+//
+// The returned pointer stays the same for the life of the program (a
+// reload updates the snapshot in place). NULL (after perror) if the file
+// cannot be read. Not thread-safe: look images up before starting workers.
+// ---------------------------------------------------------------------
+#define MEM_IMAGE_MAX  16   // distinct files kept in the registry
+
+const uint8_t *mem_image_get(const char *fname);
+
+#endif // MEM_IMAGE_H
@@ -0,0 +1,251 @@
+// mem_table.c
+// Exhaustive tabulation of pure guest routines (see mem_table.h).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "job_pool.h"
+#include "mem_table.h"
+
+uint32_t mem_table_hash(const uint8_t img[MEM_SIZE]) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < MEM_SIZE; i++) {
+        h ^= img[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// ---------------------------------------------------------------------
+// Static purity check: walk every instruction reachable from PC 0; code[]
+// gets its bytes
+// ---------------------------------------------------------------------
+static int check_static(const mem_table_t *t, const uint8_t img[MEM_SIZE],
+                        uint8_t code[MEM_SIZE], char *err, size_t errlen) {
+    uint8_t reach[MEM_SIZE] = { 0 }, work[MEM_SIZE];
+    int top = 0;
+
+    work[top++] = 0;
+    reach[0] = 1;
+    while (top > 0) {
+        uint8_t pc = work[--top];
+        uint8_t op = img[pc], arg = img[(uint8_t)(pc + 1)];
+        uint8_t next = (uint8_t)(pc + cpu_insn_len(op));
+        uint8_t succ[2];
+        int n = 0;
+
+        if (!isa_find(op)) {
+            snprintf(err, errlen, "unknown opcode 0x%02X at 0x%02X", op, pc);
+            return -1;
+        } else if (op == PRINT) {
+            snprintf(err, errlen, "PRINT at 0x%02X (side effect)", pc);
+            return -1;
+        } else if (isa_kind(op) == ISA_JUMP) {
+            succ[n++] = arg;
+            if (op != JMP) succ[n++] = next;    // JZ, JNZ, JC
+        } else if (op != HALT) {
+            succ[n++] = next;
+        }
+        for (int k = 0; k < cpu_insn_len(op); k++)
+            code[(uint8_t)(pc + k)] = 1;
+        for (int i = 0; i < n; i++) {
+            if (!reach[succ[i]]) {
+                reach[succ[i]] = 1;
+                work[top++] = succ[i];
+            }
+        }
+    }
+
+    for (int pc = 0; pc < MEM_SIZE; pc++) {
+        if (reach[pc] && img[pc] == STORE && code[img[(uint8_t)(pc + 1)]]) {
+            snprintf(err, errlen, "STORE at 0x%02X writes code byte 0x%02X",
+                     pc, img[(uint8_t)(pc + 1)]);
+            return -1;
+        }
+    }
+    for (int i = 0; i < t->ninputs; i++) {
+        if (code[t->in[i]]) {
+            snprintf(err, errlen, "input address 0x%02X is code", t->in[i]);
+            return -1;
+        }
+    }
+    if (code[t->out]) {
+        snprintf(err, errlen, "output address 0x%02X is code", t->out);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+// Exhaustive evaluation on the job pool
+// ---------------------------------------------------------------------
+enum { RUN_OK, RUN_NO_HALT, RUN_IMPURE, RUN_SMC };
+
+#define NFILLS 3    // pristine image + two random fills outside it
+
+typedef struct {
+    mem_table_t *t;
+    uint8_t imgs[NFILLS][MEM_SIZE];
+    uint8_t code[MEM_SIZE];     // 1 = code byte (check_static)
+    cpu_t  *cpus;       // one per worker
+    uint8_t *status;    // RUN_* per input
+} build_t;
+
+static void build_job(void *arg, size_t index, int worker) {
+    build_t *b = (build_t *)arg;
+    mem_table_t *t = b->t;
+    cpu_t *c = &b->cpus[worker];
+    uint8_t res[NFILLS];
+
+    for (int k = 0; k < NFILLS; k++) {
+        cpu_load(c, b->imgs[k]);
+        cpu_reset(c);
+        if (t->ninputs == 2) {
+            cpu_write(c, t->in[0], (uint8_t)(index >> 8));
+            cpu_write(c, t->in[1], (uint8_t)index);
+        } else {
+            cpu_write(c, t->in[0], (uint8_t)index);
+        }
+        if (cpu_run(c) != 0) {
+            b->status[index] = RUN_NO_HALT;
+            return;
+        }
+        // the address of a STOREP/STOREX is only known now
+        for (int a = 0; a < MEM_SIZE; a++) {
+            if (b->code[a] && c->mem[a] != b->imgs[k][a]) {
+                b->status[index] = RUN_SMC;
+                return;
+            }
+        }
+        res[k] = c->mem[t->out];
+    }
+
+    t->values[index] = res[0];
+    for (int k = 1; k < NFILLS; k++) {
+        if (res[k] != res[0]) b->status[index] = RUN_IMPURE;
+    }
+}
+
+static uint32_t xorshift32(uint32_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+int mem_table_build(mem_table_t *t, const uint8_t img[MEM_SIZE], int img_len,
+                    int nworkers, char *err, size_t errlen) {
+    if (t->ninputs != 1 && t->ninputs != 2) {
+        snprintf(err, errlen, "a table takes 1 or 2 inputs");
+        return -1;
+    }
+    build_t b;
+    memset(b.code, 0, sizeof b.code);
+    if (check_static(t, img, b.code, err, errlen) != 0) return -1;
+
+    size_t n = t->ninputs == 2 ? MEM_TABLE_MAX : 256;
+    uint32_t seed = 0x9E3779B9u;
+
+    b.t = t;
+    for (int k = 0; k < NFILLS; k++) {
+        memcpy(b.imgs[k], img, MEM_SIZE);
+        for (int a = img_len; k > 0 && a < MEM_SIZE; a++)
+            b.imgs[k][a] = (uint8_t)xorshift32(&seed);
+    }
+
+    if (nworkers < 1) nworkers = job_pool_default_workers();
+    b.cpus   = aligned_alloc(CPU_CACHE_LINE, sizeof(cpu_t) * nworkers);
+    b.status = calloc(n, 1);
+    if (!b.cpus || !b.status) {
+        free(b.cpus);
+        free(b.status);
+        snprintf(err, errlen, "out of memory");
+        return -1;
+    }
+    for (int i = 0; i < nworkers; i++) cpu_init(&b.cpus[i]);
+
+    int rc = job_pool_run(n, nworkers, 256, build_job, &b);
+    if (rc != 0) snprintf(err, errlen, "could not start the job pool");
+
+    for (size_t i = 0; rc == 0 && i < n; i++) {
+        if (b.status[i] == RUN_OK) continue;
+        char input[16];
+        if (t->ninputs == 2)
+            snprintf(input, sizeof input, "%u,%u", (unsigned)(i >> 8), (unsigned)(i & 0xFF));
+        else
+            snprintf(input, sizeof input, "%u", (unsigned)i);
+        snprintf(err, errlen, b.status[i] == RUN_NO_HALT ? "input %s stops on an unknown opcode"
+                 : b.status[i] == RUN_SMC ? "input %s writes its own code"
+                 : "input %s: result depends on memory outside the image", input);
+        rc = -1;
+    }
+
+    t->image_hash = mem_table_hash(img);
+    free(b.cpus);
+    free(b.status);
+    return rc;
+}
+
+// ---------------------------------------------------------------------
+// Table files
+// ---------------------------------------------------------------------
+#define HEADER_SIZE 12
+
+int mem_table_save(const mem_table_t *t, const char *fname) {
+    FILE *f = fopen(fname, "wb");
+    if (!f) {
+        perror(fname);
+        return -1;
+    }
+
+    uint8_t h[HEADER_SIZE];
+    memcpy(h, MEM_TABLE_MAGIC, 4);
+    h[4] = (uint8_t)t->ninputs;
+    h[5] = t->in[0];
+    h[6] = t->in[1];
+    h[7] = t->out;
+    for (int i = 0; i < 4; i++)
+        h[8 + i] = (uint8_t)(t->image_hash >> (8 * i));
+
+    size_t n = t->ninputs == 2 ? MEM_TABLE_MAX : 256;
+    int ok = fwrite(h, 1, HEADER_SIZE, f) == HEADER_SIZE &&
+             fwrite(t->values, 1, n, f) == n;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        perror(fname);
+        return -1;
+    }
+    return 0;
+}
+
+int mem_table_load(mem_table_t *t, const char *fname) {
+    FILE *f = fopen(fname, "rb");
+    if (!f) {
+        perror(fname);
+        return -1;
+    }
+
+    uint8_t h[HEADER_SIZE];
+    int ok = fread(h, 1, HEADER_SIZE, f) == HEADER_SIZE &&
+             memcmp(h, MEM_TABLE_MAGIC, 4) == 0 && (h[4] == 1 || h[4] == 2);
+    if (ok) {
+        t->ninputs = h[4];
+        t->in[0]   = h[5];
+        t->in[1]   = h[6];
+        t->out     = h[7];
+        t->image_hash = 0;
+        for (int i = 0; i < 4; i++)
+            t->image_hash |= (uint32_t)h[8 + i] << (8 * i);
+
+        size_t n = t->ninputs == 2 ? MEM_TABLE_MAX : 256;
+        ok = fread(t->values, 1, n, f) == n;
+    }
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: not a valid table file\n", fname);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// mem_table.h
+// Exhaustive tabulation of pure guest routines.
+//
+// A routine such as factorial.mem (N at 0xC0 -> RESULT at 0xC1) or
+// suma.mem (A, B at 0x20, 0x21 -> RES at 0x22) maps one or two input
+// bytes to one output byte, so its whole behavior is a table of 256 or
+// 65536 entries. mem_table_build() runs the routine for every input on a
+// job_pool (one cpu_t per worker) and the drivers then look results up in
+// O(1) instead of running the interpreter.
+//
+// Only pure routines are accepted:
+//   - no PRINT and no unknown opcode reachable from PC 0, and no STORE
+//     into its own code (which would make that check meaningless; the
+//     address of STOREP/STOREX is only known at run time, so the code
+//     bytes are compared with the image after every run);
+//   - every run reaches HALT;
+//   - the result depends only on the image and the declared inputs: each
+//     input is also run with every byte outside the image (and not an
+//     input) filled with random values, and the result must not change.
+// A routine that never halts makes mem_table_build() hang; the tabulate
+// tool guards against that with a timeout.
+
+#ifndef MEM_TABLE_H
+#define MEM_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_core.h"
+
+#define MEM_TABLE_MAGIC  "M8TB"     // file header
+#define MEM_TABLE_MAX    65536      // entries for two inputs
+
+typedef struct {
+    int      ninputs;               // 1 or 2
+    uint8_t  in[2];                 // input addresses (in[1] unused with 1 input)
+    uint8_t  out;                   // result address
+    uint32_t image_hash;            // mem_table_hash() of the image tabulated
+    uint8_t  values[MEM_TABLE_MAX]; // values[a] or values[a << 8 | b]
+} mem_table_t;
+
+// FNV-1a over the 256 bytes; lets a driver reject a table built from an
+// older version of the image.
+uint32_t mem_table_hash(const uint8_t img[MEM_SIZE]);
+
+// Fills t->values for the routine in img (img_len = bytes the image file
+// holds, as returned by mem_image_read). t->ninputs, t->in and t->out must
+// be set. Returns 0, or -1 with the reason in err if the routine is not
+// pure or the job pool cannot start.
+int mem_table_build(mem_table_t *t, const uint8_t img[MEM_SIZE], int img_len,
+                    int nworkers, char *err, size_t errlen);
+
+// Binary file: magic, ninputs, in[2], out, image_hash (little endian),
+// then 256 or 65536 values. Both return 0, or -1 after reporting why.
+int mem_table_save(const mem_table_t *t, const char *fname);
+int mem_table_load(mem_table_t *t, const char *fname);
+
+static inline uint8_t mem_table_get1(const mem_table_t *t, uint8_t a) {
+    return t->values[a];
+}
+
+static inline uint8_t mem_table_get2(const mem_table_t *t, uint8_t a, uint8_t b) {
+    return t->values[(unsigned)a << 8 | b];
+}
+
+#endif // MEM_TABLE_H
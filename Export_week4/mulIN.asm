@@ -0,0 +1,49 @@
+; mul.asm — producto A * B con sumas repetidas -> P
+; ISA: LOAD=0x01, ADD=0x02, STORE=0x03, JMP=0x04, JZ=0x05, HALT=0xFF
+;
+; Contrato con C:
+;   - C debe escribir A en 0x40 y B en 0x41
+;   - Al terminar, P (0x42) contiene A * B (mod 256)
+;
+; Esquema:
+;   P = 0
+;   CNT = B
+;   while CNT != 0:
+;       P += A
+;       CNT -= 1
+
+        .org 0x00
+MUL:
+        LOAD  ZERO
+        STORE P
+        LOAD  B
+        STORE CNT
+
+LOOP:
+        ; if CNT == 0 goto DONE
+        LOAD  CNT
+        JZ    DONE
+
+        ; P = P + A
+        LOAD  P
+        ADD   A
+        STORE P
+
+        ; CNT = CNT - 1
+        LOAD  CNT
+        ADD   NEG1
+        STORE CNT
+        JMP   LOOP
+
+DONE:
+        LOAD  P         ; ACC = P
+        HALT
+
+; ---------------- DATA ----------------
+        .org 0x40
+A:      .byte 0         ; <- C pone aquí A
+B:      .byte 0         ; <- C pone aquí B
+P:      .byte 0         ; <- aquí queda el producto
+CNT:    .byte 0
+ZERO:   .byte 0
+NEG1:   .byte 255       ; 0xFF = -1 en aritmética de 8 bits
@@ -0,0 +1,83 @@
+// profile.c
+// Runs an image under cpu_run_profile() and prints where the time goes,
+// line by line of its assembler listing (see cpu_profile.h).
+//
+// Usage: ./profile.x image.mem|.obj image.lst [ADDR=VALUE ...] [-n RUNS]
+//                    [--bounds] [--trace]
+//
+//   ./profile.x factorial.mem factorial.lst 0xC0=5
+//   ./profile.x suma.mem suma.lst 0x20=120 0x21=6 -n 100
+//
+// ADDR=VALUE bytes are written into the image before every run (the
+// inputs of the routine); -n runs it RUNS times (default 1) and reports
+// the counts added up. The program must reach HALT. --bounds stops it if
+// it runs past 0xFF and --trace prints every instruction; both pick the
+// interpreter variant with those checks (cpu_engine), which also profiles.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_core.h"
+#include "cpu_profile.h"
+#include "mem_image.h"
+
+#define MAX_INPUTS 16
+
+int main(int argc, char **argv) {
+    const char *pos[2];
+    int npos = 0, ninputs = 0;
+    long runs = 1;
+    unsigned policy = CPU_POLICY_PROFILE;
+    uint8_t in_addr[MAX_INPUTS], in_val[MAX_INPUTS];
+
+    for (int i = 1; i < argc; i++) {
+        char *eq = strchr(argv[i], '=');
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--bounds") == 0) {
+            policy |= CPU_POLICY_BOUNDS;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            policy |= CPU_POLICY_TRACE;
+        } else if (eq && ninputs < MAX_INPUTS) {
+            in_addr[ninputs] = (uint8_t)strtol(argv[i], NULL, 0);
+            in_val[ninputs]  = (uint8_t)strtol(eq + 1, NULL, 0);
+            ninputs++;
+        } else if (!eq && npos < 2) {
+            pos[npos++] = argv[i];
+        } else {
+            npos = 0;   // print usage
+            break;
+        }
+    }
+    if (npos != 2 || runs < 1) {
+        fprintf(stderr, "Usage: %s image.mem image.lst [ADDR=VALUE ...] [-n RUNS] "
+                "[--bounds] [--trace]\n", argv[0]);
+        return 1;
+    }
+
+    uint8_t img[MEM_SIZE];
+    if (mem_image_read_any(pos[0], img) < 0) return 1;
+
+    static cpu_t c;
+    static cpu_profile_t prof;
+    cpu_engine_t run = cpu_engine(policy);
+    cpu_init(&c);
+    c.profile = &prof;
+
+    for (long r = 0; r < runs; r++) {
+        cpu_load(&c, img);
+        for (int i = 0; i < ninputs; i++)
+            cpu_write(&c, in_addr[i], in_val[i]);
+        cpu_reset(&c);
+        int st = run(&c);
+        if (st != CPU_HALTED) {
+            fprintf(stderr, "%s: stopped at PC=0x%02X (%s)\n", pos[0], c.PC,
+                    st == CPU_OUT_OF_BOUNDS ? "ran past 0xFF" : "unknown opcode");
+            return 1;
+        }
+    }
+
+    return cpu_profile_report(stdout, &prof, pos[1]) == 0 ? 0 : 1;
+}
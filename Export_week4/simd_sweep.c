@@ -0,0 +1,94 @@
+// simd_sweep.c
+// Parameter sweep of a single-input guest routine on the lane-parallel
+// interpreter (cpu_simd.c), checked lane by lane against cpu_run().
+//
+// Usage: ./simd_sweep.x [image.mem] [in_addr] [out_addr] [repeats]
+//        defaults: factorial.mem 0xC0 0xC1 5
+//
+// Every input value 0..255 is written to in_addr; the byte at out_addr,
+// ACC and PC after HALT must match between both engines. Prints the
+// runs/sec of each engine and the speedup.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_core.h"
+#include "cpu_simd.h"
+#include "mem_image.h"
+
+#define NINPUTS 256
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    const char *image = argc > 1 ? argv[1] : "factorial.mem";
+    uint8_t in_addr   = (uint8_t)(argc > 2 ? strtol(argv[2], NULL, 0) : 0xC0);
+    uint8_t out_addr  = (uint8_t)(argc > 3 ? strtol(argv[3], NULL, 0) : 0xC1);
+    int repeats       = argc > 4 ? atoi(argv[4]) : 5;
+    if (repeats < 1) repeats = 1;
+
+    uint8_t img[MEM_SIZE];
+    if (mem_image_read(image, img) < 0) return 1;
+
+    uint8_t ref_out[NINPUTS], ref_acc[NINPUTS], ref_pc[NINPUTS];
+    static cpu_t c;
+    static cpu_simd_t s;
+
+    // Scalar reference
+    double t0 = now_sec();
+    for (int r = 0; r < repeats; r++) {
+        for (int n = 0; n < NINPUTS; n++) {
+            cpu_init(&c);
+            memcpy(c.mem, img, MEM_SIZE);
+            c.mem[in_addr] = (uint8_t)n;
+            cpu_run(&c);
+            ref_out[n] = c.mem[out_addr];
+            ref_acc[n] = c.ACC;
+            ref_pc[n]  = c.PC;
+        }
+    }
+    double t_scalar = now_sec() - t0;
+
+    // Lane-parallel, CPU_SIMD_LANES inputs per run
+    int mismatches = 0;
+    t0 = now_sec();
+    for (int r = 0; r < repeats; r++) {
+        for (int base = 0; base < NINPUTS; base += CPU_SIMD_LANES) {
+            int nlanes = NINPUTS - base < CPU_SIMD_LANES ? NINPUTS - base : CPU_SIMD_LANES;
+            cpu_simd_load(&s, img);
+            for (int l = 0; l < nlanes; l++)
+                cpu_simd_poke(&s, l, in_addr, (uint8_t)(base + l));
+            cpu_simd_run(&s, nlanes);
+
+            if (r > 0) continue;
+            for (int l = 0; l < nlanes; l++) {
+                int n = base + l;
+                if (cpu_simd_peek(&s, l, out_addr) != ref_out[n] ||
+                    s.acc[l] != ref_acc[n] || s.pc[l] != ref_pc[n]) {
+                    fprintf(stderr, "mismatch for input %d: simd out=%u acc=%u pc=0x%02X, "
+                            "scalar out=%u acc=%u pc=0x%02X\n",
+                            n, cpu_simd_peek(&s, l, out_addr), s.acc[l], s.pc[l],
+                            ref_out[n], ref_acc[n], ref_pc[n]);
+                    mismatches++;
+                }
+            }
+        }
+    }
+    double t_simd = now_sec() - t0;
+
+    double runs = (double)NINPUTS * repeats;
+    printf("%s: %d inputs x %d repeats, %d lanes\n", image, NINPUTS, repeats, CPU_SIMD_LANES);
+    printf("  scalar: %10.0f runs/s\n", runs / t_scalar);
+    printf("  simd:   %10.0f runs/s  (x%.2f)\n", runs / t_simd, t_scalar / t_simd);
+    printf("  %s\n", mismatches ? "MISMATCH" : "all lanes match cpu_run()");
+    return mismatches ? 1 : 0;
+}
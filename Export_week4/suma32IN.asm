@@ -0,0 +1,45 @@
+; suma32.asm — suma de 32 bits A + B -> RES con acarreo
+; ISA: LOAD=0x01, ADD=0x02, STORE=0x03, ADC=0x0D, HALT=0xFF
+;
+; Contrato con C (main2link_loadmem.c --wide):
+;   - C debe escribir A en 0x20..0x23 y B en 0x24..0x27 (little endian)
+;   - Al terminar, RES (0x28..0x2B) contiene A + B (mod 2^32)
+;
+; Byte a byte, del bajo al alto: ADD el primero y ADC los demás, que suman
+; el acarreo del anterior.
+
+        ; exportados para el linker; cada byte del resultado, para que -O no
+        ; tome RES1..RES3 por variables internas y quite sus STORE
+        .global SUMA32, A, B, RES, RES1, RES2, RES3
+
+        .org 0x00
+SUMA32: LOAD  A0
+        ADD   B0
+        STORE RES0
+        LOAD  A1
+        ADC   B1
+        STORE RES1
+        LOAD  A2
+        ADC   B2
+        STORE RES2
+        LOAD  A3
+        ADC   B3
+        STORE RES3
+        HALT
+
+        .org 0x20
+A:
+A0:     .byte 0       ; <- C pone aquí FACT1 (byte bajo)
+A1:     .byte 0
+A2:     .byte 0
+A3:     .byte 0
+B:
+B0:     .byte 0       ; <- C pone aquí FACT2 (byte bajo)
+B1:     .byte 0
+B2:     .byte 0
+B3:     .byte 0
+RES:
+RES0:   .byte 0       ; <- aquí queda la suma (byte bajo)
+RES1:   .byte 0
+RES2:   .byte 0
+RES3:   .byte 0
@@ -5,8 +5,10 @@
 ;   - C debe escribir A en 0x20 y B en 0x21
 ;   - Al terminar, RES (0x22) contiene A + B (mod 256)
 
+        .global SUMA, A, B, RES   ; exportados para el linker
+
         .org 0x00
-        LOAD  A       ; ACC = [A]
+SUMA:   LOAD  A       ; ACC = [A]
         ADD   B       ; ACC = ACC + [B]
         STORE RES     ; RES = A + B
         HALT
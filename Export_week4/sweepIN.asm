@@ -0,0 +1,60 @@
+; sweep.asm — recorre TABLE y suma sus LEN bytes -> SUM
+; ISA: LOAD=0x01, ADD=0x02, STORE=0x03, JMP=0x04, JZ=0x05, HALT=0xFF
+;
+; Contrato con C:
+;   - C puede cambiar LEN (0xB1, bytes a sumar desde TABLE)
+;   - Al terminar, SUM (0xB0) contiene la suma (mod 256)
+;
+; Sin direccionamiento indirecto, el recorrido modifica el operando de su
+; propio LOAD (PTR) en cada vuelta: carga de trabajo para la caché de
+; decodificación, que debe invalidar esa entrada en cada STORE PTR.
+
+        .org 0x00
+        LOAD  ZERO
+        STORE SUM
+        LOAD  START
+        STORE PTR
+        LOAD  LEN
+        STORE COUNT
+
+LOOP:
+        ; if COUNT == 0 goto DONE
+        LOAD  COUNT
+        JZ    DONE
+
+        ; SUM = SUM + [PTR]
+FETCH:  .byte 0x01      ; LOAD (instrucción escrita a mano: PTR es su operando)
+PTR:    .byte 0x00
+        ADD   SUM
+        STORE SUM
+
+        ; PTR = PTR + 1
+        LOAD  PTR
+        ADD   ONE
+        STORE PTR
+
+        ; COUNT = COUNT - 1
+        LOAD  COUNT
+        ADD   NEG1
+        STORE COUNT
+        JMP   LOOP
+
+DONE:
+        LOAD  SUM       ; ACC = SUM
+        HALT
+
+; ---------------- DATA ----------------
+        .org 0xB0
+SUM:    .byte 0
+LEN:    .byte 64
+COUNT:  .byte 0
+START:  .byte TABLE
+ONE:    .byte 1
+NEG1:   .byte 255
+ZERO:   .byte 0
+
+        .org 0xC0
+TABLE:  .byte 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16
+        .byte 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+        .byte 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48
+        .byte 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64
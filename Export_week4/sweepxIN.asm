@@ -0,0 +1,45 @@
+; sweepx.asm — recorre TABLE con el registro X y suma sus LEN bytes -> SUM
+; ISA: LOAD=0x01, STORE=0x03, JZ=0x05, SUB=0x08, JNZ=0x09, LOADI=0x0A,
+;      ADDX=0x14, INX=0x16, TAX=0x18, TXA=0x19, HALT=0xFF
+;
+; Contrato con C (el mismo que sweep.asm):
+;   - C puede cambiar LEN (0xB1, bytes a sumar desde TABLE)
+;   - Al terminar, SUM (0xB0) contiene la suma (mod 256)
+;
+; El mismo recorrido que sweep.asm, pero el índice vive en X y ADD TABLE,X
+; lee TABLE + X: ningún STORE toca el código, así que la caché de
+; decodificación y el JIT traducen el bucle una sola vez.
+
+        .org 0x00
+        LOAD  #0
+        STORE SUM
+        TAX             ; X = 0
+        LOAD  LEN
+        JZ    DONE
+
+LOOP:
+        ; SUM = SUM + TABLE[X]
+        LOAD  SUM
+        ADD   TABLE,X
+        STORE SUM
+
+        ; X = X + 1; repetir mientras X != LEN
+        INX
+        TXA
+        SUB   LEN
+        JNZ   LOOP
+
+DONE:
+        LOAD  SUM       ; ACC = SUM
+        HALT
+
+; ---------------- DATA ----------------
+        .org 0xB0
+SUM:    .byte 0
+LEN:    .byte 64
+
+        .org 0xC0
+TABLE:  .byte 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16
+        .byte 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+        .byte 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48
+        .byte 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64
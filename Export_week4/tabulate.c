@@ -0,0 +1,89 @@
+// tabulate.c
+// Builds the lookup table of a pure guest routine (see mem_table.h).
+//
+// Usage: ./tabulate.x image.mem|.obj out.tab IN_ADDR [IN2_ADDR] OUT_ADDR [-j N] [-t SECONDS]
+//
+//   ./tabulate.x factorial.mem factorial.tab 0xC0 0xC1         256 entries
+//   ./tabulate.x suma.mem suma.tab 0x20 0x21 0x22              65536 entries
+//
+// The last address is the result, the ones before it the inputs. -j sets
+// the worker threads (default: all CPUs); -t aborts after SECONDS
+// (default 60) in case the routine does not halt for some input.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpu_core.h"
+#include "mem_image.h"
+#include "mem_table.h"
+
+static void on_timeout(int sig) {
+    static const char msg[] = "tabulate: timeout (does the routine halt for every input?)\n";
+    (void)sig;
+    write(STDERR_FILENO, msg, sizeof msg - 1);
+    _exit(1);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    const char *pos[5];
+    int npos = 0, nworkers = 0, timeout = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            nworkers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            timeout = atoi(argv[++i]);
+        } else if (npos < 5) {
+            pos[npos++] = argv[i];
+        } else {
+            npos = 0;   // too many: print usage
+            break;
+        }
+    }
+    if (npos != 4 && npos != 5) {
+        fprintf(stderr, "Usage: %s image.mem out.tab IN_ADDR [IN2_ADDR] OUT_ADDR "
+                "[-j N] [-t SECONDS]\n", argv[0]);
+        return 1;
+    }
+
+    static mem_table_t t;
+    t.ninputs = npos - 3;
+    t.in[0] = (uint8_t)strtol(pos[2], NULL, 0);
+    t.in[1] = t.ninputs == 2 ? (uint8_t)strtol(pos[3], NULL, 0) : 0;
+    t.out   = (uint8_t)strtol(pos[npos - 1], NULL, 0);
+
+    uint8_t img[MEM_SIZE];
+    int len = mem_image_read_any(pos[0], img);
+    if (len < 0) return 1;
+
+    signal(SIGALRM, on_timeout);
+    alarm(timeout > 0 ? (unsigned)timeout : 0);
+
+    char err[128];
+    double t0 = now_sec();
+    if (mem_table_build(&t, img, len, nworkers, err, sizeof err) != 0) {
+        fprintf(stderr, "%s: not tabulable: %s\n", pos[0], err);
+        return 1;
+    }
+    double dt = now_sec() - t0;
+    alarm(0);
+
+    if (mem_table_save(&t, pos[1]) != 0) return 1;
+
+    size_t n = t.ninputs == 2 ? MEM_TABLE_MAX : 256;
+    printf("Tabulated %s -> %s (%zu entries, %.3f s)\n", pos[0], pos[1], n, dt);
+    return 0;
+}